@@ -2,7 +2,7 @@
 #define __BRANCH_PREDICTOR_HPP__
 
 #include <vector>
-#include <bitset>
+#include <cstdint>
 #include <cassert>
 #include <bits/stdc++.h>
 using namespace std;
@@ -10,195 +10,119 @@ using namespace std;
 struct BranchPredictor {
     virtual bool predict(uint32_t pc) = 0;
     virtual void update(uint32_t pc, bool taken) = 0;
+    virtual ~BranchPredictor() {}
 };
 
+// direct mapped branch target buffer: the target each entry last saw, tagged with the full pc
+struct BranchTargetBuffer {
+    std::vector<int> tags, targets;
+    BranchTargetBuffer(int size) : tags(size, -1), targets(size, 0) {}
+
+    // the target recorded for pc, -1 if its entry belongs to another instruction
+    int lookup(uint32_t pc) {
+        int entry = pc % tags.size();
+        return tags[entry] == (int)pc ? targets[entry] : -1;
+    }
+
+    void update(uint32_t pc, int target) {
+        int entry = pc % tags.size();
+        tags[entry] = pc;
+        targets[entry] = target;
+    }
+};
+
+/*
+    2-bit values packed 32 to a 64-bit word, so a table of 1 << 14 counters takes 4 KB.
+    Counters saturate at 0 and 3 and predict taken from 2 up; a history holds the last two outcomes
+*/
+struct PackedCounterTable {
+    // the next counter value: bits 2v..2v+1 for value v when not taken, 8 bits higher when taken
+    static const uint32_t SATURATE = 0xF990;
+    std::vector<uint64_t> words;
+    PackedCounterTable(size_t size, int value) : words((size + 31) / 32, 0x5555555555555555ull * (value & 3)) {}
+
+    int get(size_t i) const {
+        return words[i >> 5] >> ((i & 31) * 2) & 3;
+    }
+    void set(size_t i, int value) {
+        int shift = (i & 31) * 2;
+        uint64_t &word = words[i >> 5];
+        word = (word & ~(3ull << shift)) | (uint64_t)value << shift;
+    }
+    bool taken(size_t i) const {
+        return get(i) >> 1;
+    }
+    // one step towards 3 on a taken branch, towards 0 otherwise
+    void count(size_t i, bool taken) {
+        set(i, SATURATE >> (taken * 8 + get(i) * 2) & 3);
+    }
+    // shift the outcome into a history
+    void record(size_t i, bool taken) {
+        set(i, (get(i) << 1 | taken) & 3);
+    }
+};
+
+// a counter per pc, indexed by the low 14 bits
 struct SaturatingBranchPredictor : public BranchPredictor {
-    std::vector<std::bitset<2>> table;
+    static const uint32_t MASK = (1 << 14) - 1;
+    PackedCounterTable table;
     SaturatingBranchPredictor(int value) : table(1 << 14, value) {}
 
     bool predict(uint32_t pc) {
-        pc=(pc<<18);
-        pc=(pc>>18);
-        if(table[pc].test(1)){return true;}
-        else {false;}
-        return false;
-        
+        return table.taken(pc & MASK);
     }
 
     void update(uint32_t pc, bool taken) {
-        pc=(pc<<18);
-        pc=(pc>>18);
-        if(taken)
-        {
-            if(!table[pc].test(0))
-            {
-                table[pc].set(0);
-            }
-            else
-            {
-                if(!(table[pc].test(1)))
-                {
-                    table[pc].set(1);
-                    table[pc].reset(0);
-                }
-            }
-        }
-        else
-        {
-            if(table[pc].test(0))
-            {
-                table[pc].reset(0);
-            }
-            else
-            {
-                if(table[pc].test(1))
-                {
-                    table[pc].reset(1);
-                    table[pc].set(0);
-                }
-            }
-        }
+        table.count(pc & MASK, taken);
     }
 };
 
+// a counter per global history of the last two outcomes
 struct BHRBranchPredictor : public BranchPredictor {
-    std::vector<std::bitset<2>> bhrTable;
-    std::bitset<2> bhr;
-    BHRBranchPredictor(int value) : bhrTable(1 << 2, value), bhr(value) {}
+    PackedCounterTable bhrTable;
+    int bhr;
+    BHRBranchPredictor(int value) : bhrTable(1 << 2, value), bhr(value & 3) {}
 
     bool predict(uint32_t pc) {
-        int x= bhr.to_ulong();
-        std :: bitset<2> dum = bhrTable[x];
-         if(dum.test(1)){return true;}
-        else {false;}
-        return false;
+        return bhrTable.taken(bhr);
     }
 
     void update(uint32_t pc, bool taken) {
-        int x= bhr.to_ulong();
-        std :: bitset<2> dum = bhrTable[x];
-        if(taken)
-        {
-            if(!bhrTable[x].test(0))
-            {
-                bhrTable[x].set(0);
-            }
-            else
-            {
-                if(!(bhrTable[x].test(1)))
-                {
-                    bhrTable[x].set(1);
-                    bhrTable[x].reset(0);
-                }
-            }
-        }
-        else
-        {
-            if(bhrTable[x].test(0))
-            {
-                bhrTable[x].reset(0);
-            }
-            else
-            {
-                if(bhrTable[x].test(1))
-                {
-                    bhrTable[x].reset(1);
-                    bhrTable[x].set(0);
-                }
-            }
-        }
-        if(bhr.test(0))
-        {
-            bhr.set(1);
-        }
-        else
-        {
-            bhr.reset(1);
-        }
-        if(taken)
-        {
-            bhr.set(0);
-        }
-        else
-        {
-            bhr.reset(0);
-        }
+        bhrTable.count(bhr, taken);
+        bhr = (bhr << 1 | taken) & 3;
     }
 };
 
+// a history of the last two outcomes per pc, selecting one of four counters of that pc
 struct SaturatingBHRBranchPredictor : public BranchPredictor {
-    std::vector<std::bitset<2>> bhrTable;
-    std::bitset<2> bhr;
-    std::vector<std::bitset<2>> table;
-    std::vector<std::bitset<2>> combination;
-    SaturatingBHRBranchPredictor(int value, int size) : bhrTable(1 << 2, value), bhr(value), table(1 << 14, value), combination(size, value) {
+    static const uint32_t MASK = (1 << 14) - 1;
+    PackedCounterTable table;
+    PackedCounterTable combination;
+    SaturatingBHRBranchPredictor(int value, int size) : table(1 << 14, value), combination(size, value) {
         assert(size <= (1 << 16));
     }
 
     bool predict(uint32_t pc) {
-        pc=(pc<<18);
-        pc=(pc>>18);
-        int x = table[pc].to_ulong();
-        std::bitset<2> dum = combination[4*pc+x];
-        if(dum.test(1)){return true;}
-        else {false;}
-        return false;
+        pc &= MASK;
+        return combination.taken(4 * pc + table.get(pc));
     }
 
     void update(uint32_t pc, bool taken) {
-        pc=(pc<<18);
-        pc=(pc>>18);
-        long long int num = table[pc].to_ulong();
-        long long int x=4*pc+num;
-        
-        if(taken)
-        {
-            if(!combination[x].test(0))
-            {
-                combination[x].set(0);
-            }
-            else
-            {
-                if(!(combination[x].test(1)))
-                {
-                    combination[x].set(1);
-                    combination[x].reset(0);
-                }
-            }
-        }
-        else
-        {
-            if(combination[x].test(0))
-            {
-                combination[x].reset(0);
-            }
-            else
-            {
-                if(combination[x].test(1))
-                {
-                    combination[x].reset(1);
-                    combination[x].set(0);
-                }
-            }
-        }
-        
-        if(table[pc].test(0))
-        {
-            table[pc].set(1);
-        }
-        else
-        {
-            table[pc].reset(1);
-        }
-        if(taken)
-        {
-            table[pc].set(0);
-        }
-        else
-        {
-            table[pc].reset(0);
-        }
+        pc &= MASK;
+        combination.count(4 * pc + table.get(pc), taken);
+        table.record(pc, taken);
     }
 };
 
-#endif
\ No newline at end of file
+// the named predictor with its counters starting in the given state, nullptr if there is no such predictor
+inline BranchPredictor *makePredictor(const std::string &kind, int state) {
+    if (kind == "saturating")
+        return new SaturatingBranchPredictor(state);
+    if (kind == "bhr")
+        return new BHRBranchPredictor(state);
+    if (kind == "saturating-bhr")
+        return new SaturatingBHRBranchPredictor(state, 1 << 16);
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * @file MIPS_CpiStack.hpp
+ * @brief Cycle accounting shared by the pipelined engines: every cycle of a run
+ * is charged to one cause, either an instruction completing in it or the reason
+ * nothing completed, so the causes add up to the total cycle count. The result
+ * is a CPI stack, broken down further by register and by instruction.
+ *
+ */
+
+#ifndef __MIPS_CPI_STACK_HPP__
+#define __MIPS_CPI_STACK_HPP__
+
+#include <array>
+#include <string_view>
+#include <vector>
+#include <iostream>
+
+enum StallCause
+{
+	BASE,			 // an instruction completed
+	PIPELINE_DEPTH,	 // the first instructions travel through an empty pipeline
+	DATA_HAZARD,	 // a source register has a write pending
+	EXECUTE_LATENCY, // a result is not ready yet, or the unit takes no new instruction
+	STRUCTURAL,		 // a free slot, the memory port or a reservation station is missing
+	WRITE_PORT,		 // the two paths of a split pipeline take turns writing registers
+	LOAD_WAIT,		 // a load waits for data memory
+	STORE_WAIT,		 // a store waits for data memory or a free store buffer entry
+	CONTROL,		 // fetch waits for a branch or jump, or refills after a redirect
+	DRAIN,			 // buffered stores complete after the last instruction
+	STALL_CAUSES
+};
+
+struct CpiStack
+{
+	static constexpr const char *NAMES[STALL_CAUSES] = {"base", "pipeline depth", "data hazard", "execute latency", "structural",
+														"write port", "load wait", "store wait", "control", "drain"};
+	static constexpr const char *REGISTER_NAMES[32] = {"$zero", "$at", "$v0", "$v1", "$a0", "$a1", "$a2", "$a3", "$t0", "$t1", "$t2",
+													   "$t3", "$t4", "$t5", "$t6", "$t7", "$s0", "$s1", "$s2", "$s3", "$s4", "$s5",
+													   "$s6", "$s7", "$t8", "$t9", "$k0", "$k1", "$gp", "$sp", "$s8", "$ra"};
+	long long cycles[STALL_CAUSES] = {0};
+	long long registerCycles[32] = {0}; // data hazard cycles by the register waited for
+	long long instructions = 0;
+	std::vector<std::array<long long, STALL_CAUSES>> byPc;
+
+	void reset(size_t programSize)
+	{
+		*this = CpiStack();
+		byPc.assign(programSize, std::array<long long, STALL_CAUSES>());
+	}
+
+	// n cycles go to the cause, on behalf of the instruction at pc (-1 for none); reg is the register of a data hazard
+	void charge(StallCause cause, int pc, int reg, long long n)
+	{
+		cycles[cause] += n;
+		if (cause == DATA_HAZARD && reg >= 0)
+			registerCycles[reg] += n;
+		if (pc >= 0)
+			byPc[pc][cause] += n;
+	}
+
+	void print(const std::vector<std::array<std::string_view, 4>> &commands)
+	{
+		long long total = 0;
+		for (long long n : cycles)
+			total += n;
+		double perInstruction = instructions > 0 ? 1.0 / instructions : 0;
+		std::cerr << "CPI stack over " << instructions << " instructions and " << total << " cycles, CPI " << total * perInstruction << ":\n";
+		for (int cause = 0; cause < STALL_CAUSES; ++cause)
+			if (cycles[cause] > 0)
+				std::cerr << NAMES[cause] << ": " << cycles[cause] << " cycles, " << cycles[cause] * perInstruction << " CPI\n";
+		std::cerr << "Data hazard cycles by register:\n";
+		for (int reg = 0; reg < 32; ++reg)
+			if (registerCycles[reg] > 0)
+				std::cerr << REGISTER_NAMES[reg] << ": " << registerCycles[reg] << '\n';
+		std::cerr << "Cycles by instruction:\n";
+		for (size_t pc = 0; pc < byPc.size(); ++pc)
+		{
+			long long sum = 0;
+			for (long long n : byPc[pc])
+				sum += n;
+			if (sum == 0)
+				continue;
+			std::cerr << sum << " cycles (";
+			const char *separator = "";
+			for (int cause = 0; cause < STALL_CAUSES; ++cause)
+				if (byPc[pc][cause] > 0)
+					std::cerr << separator << NAMES[cause] << ' ' << byPc[pc][cause], separator = ", ";
+			std::cerr << "):\t";
+			for (auto &s : commands[pc])
+				std::cerr << s << ' ';
+			std::cerr << '\n';
+		}
+	}
+};
+
+#endif
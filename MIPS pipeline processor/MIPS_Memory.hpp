@@ -0,0 +1,123 @@
+/**
+ * @file MIPS_Memory.hpp
+ * @brief Sparse data memory shared by every MIPS_Architecture engine: the full
+ * 32-bit byte address space, allocated lazily in 4 KB pages behind a two-level table.
+ *
+ */
+
+#ifndef __MIPS_MEMORY_HPP__
+#define __MIPS_MEMORY_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+struct PagedMemory
+{
+	// word addressed: 2^30 words, 1024 words (4 KB) per page, 1024 pages per table, 1024 tables
+	static const int PAGE_BITS = 10, TABLE_BITS = 10;
+	static const uint32_t WORD_MASK = (1u << 30) - 1, PAGE_WORDS = 1u << PAGE_BITS, TABLE_PAGES = 1u << TABLE_BITS;
+	static const uint32_t TABLES = 1u << (30 - PAGE_BITS - TABLE_BITS), NO_PAGE = ~0u;
+
+	// a page remembers which of its words were ever written
+	struct Page
+	{
+		int words[PAGE_WORDS] = {0};
+		uint64_t dirty[PAGE_WORDS / 64] = {0};
+	};
+	struct Table
+	{
+		std::unique_ptr<Page> pages[TABLE_PAGES];
+	};
+	std::unique_ptr<Table> tables[TABLES];
+	std::vector<uint32_t> touchedPages; // page numbers in allocation order
+	std::vector<uint32_t> deltas;		// words written through writeDelta since the last clearDeltas
+	// last page looked up, so runs of accesses to one page skip the table walk
+	mutable uint32_t cachedNumber = NO_PAGE;
+	mutable Page *cachedPage = nullptr;
+
+	// the page with the given page number, nullptr if it was never written
+	Page *findPage(uint32_t number) const
+	{
+		const Table *table = tables[number >> TABLE_BITS].get();
+		return table == nullptr ? nullptr : table->pages[number & (TABLE_PAGES - 1)].get();
+	}
+
+	// the page with the given page number, allocated zero filled on first use
+	Page *allocatePage(uint32_t number)
+	{
+		std::unique_ptr<Table> &table = tables[number >> TABLE_BITS];
+		if (table == nullptr)
+			table.reset(new Table());
+		std::unique_ptr<Page> &page = table->pages[number & (TABLE_PAGES - 1)];
+		if (page == nullptr)
+		{
+			page.reset(new Page());
+			touchedPages.push_back(number);
+		}
+		return page.get();
+	}
+
+	// value of the word at the given word index, reading never allocates
+	int read(uint32_t word) const
+	{
+		word &= WORD_MASK;
+		uint32_t number = word >> PAGE_BITS;
+		if (number != cachedNumber)
+		{
+			Page *page = findPage(number);
+			if (page == nullptr)
+				return 0;
+			cachedNumber = number, cachedPage = page;
+		}
+		return cachedPage->words[word & (PAGE_WORDS - 1)];
+	}
+
+	// store to the word at the given word index, negative indices wrap to the top of memory
+	void write(uint32_t word, int value)
+	{
+		word &= WORD_MASK;
+		uint32_t number = word >> PAGE_BITS, offset = word & (PAGE_WORDS - 1);
+		if (number != cachedNumber)
+			cachedPage = allocatePage(number), cachedNumber = number;
+		cachedPage->words[offset] = value;
+		cachedPage->dirty[offset >> 6] |= 1ull << (offset & 63);
+	}
+
+	// store and record the word as changed for the per-cycle memory delta
+	void writeDelta(uint32_t word, int value)
+	{
+		write(word, value);
+		word &= WORD_MASK;
+		if (std::find(deltas.begin(), deltas.end(), word) == deltas.end())
+			deltas.push_back(word);
+	}
+
+	void clearDeltas()
+	{
+		deltas.clear();
+	}
+
+	// calls visit(word index, value) for every non-zero word, in address order.
+	// Only words that were written are looked at, so the cost follows the writes, not the memory size
+	template <typename Visitor>
+	void forEachNonZero(Visitor visit) const
+	{
+		std::vector<uint32_t> pages(touchedPages);
+		std::sort(pages.begin(), pages.end());
+		for (uint32_t number : pages)
+		{
+			const Page *page = findPage(number);
+			for (uint32_t d = 0; d < PAGE_WORDS / 64; ++d)
+				for (uint64_t bits = page->dirty[d]; bits != 0; bits &= bits - 1)
+				{
+					uint32_t offset = d * 64 + __builtin_ctzll(bits);
+					if (page->words[offset] != 0)
+						visit((number << PAGE_BITS) | offset, page->words[offset]);
+				}
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,508 @@
+/**
+ * @file MIPS_OutOfOrder.hpp
+ * @brief Out-of-order engine next to the in-order pipelines (Tomasulo with a
+ * reorder buffer): registers are renamed to reorder buffer entries, instructions
+ * wait in reservation stations until their operands are broadcast, loads and
+ * stores go through a load/store queue, and the reorder buffer commits in
+ * program order, so the architectural state follows the in-order engines.
+ *
+ */
+
+#ifndef __MIPS_OUT_OF_ORDER_HPP__
+#define __MIPS_OUT_OF_ORDER_HPP__
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <iostream>
+#include "MIPS_Program.hpp"
+#include "MIPS_Memory.hpp"
+#include "MIPS_Trace.hpp"
+#include "BranchPredictor.hpp"
+#include "MIPS_CpiStack.hpp"
+#include "MIPS_Profile.hpp"
+
+// functional units, each kind with its own count and latency
+enum UnitKind
+{
+	ALU_UNIT,	 // add, sub, slt, addi, beq, bne
+	MUL_UNIT,	 // mul
+	MEMORY_UNIT, // lw and sw: the address, then the load/store queue or data memory
+	UNIT_KINDS
+};
+
+/*
+	robSize: reorder buffer entries; width: instructions fetched, dispatched and committed per cycle
+	stations: reservation stations shared by all units; lsqSize: loads and stores in flight
+	units, latency: per UnitKind, every unit is pipelined. A store only computes its address
+		in the memory unit, it writes data memory when it commits
+*/
+struct OutOfOrderConfig
+{
+	int robSize = 32, width = 2, stations = 16, lsqSize = 8;
+	int units[UNIT_KINDS] = {2, 1, 1};
+	int latency[UNIT_KINDS] = {1, 1, 1};
+};
+
+struct MIPS_OutOfOrder : MIPS_Program
+{
+	/*
+		an instruction between dispatch and commit:
+		value: the result, branch outcome, loaded word or store data; address: the word index
+		done: the result was broadcast; executed: a load or store knows its address
+		predictedTaken: fetch followed the branch target
+	*/
+	struct RobEntry
+	{
+		int pc = 0, order = 0, value = 0, address = 0;
+		bool done = false, executed = false, predictedTaken = false;
+	};
+	// an instruction waiting for its operands: tag is the ROB entry producing one, -1 once value holds it
+	struct Station
+	{
+		int entry = 0, tag[2] = {-1, -1}, value[2] = {0, 0};
+	};
+	struct Fetched
+	{
+		int pc = 0;
+		bool predictedTaken = false;
+	};
+	struct Executing
+	{
+		int entry = 0, finish = 0;
+	};
+
+	OutOfOrderConfig config;
+	int registers[32] = {0}, PCcurr = 0;
+	int rename[32]; // ROB entry producing the newest value of each register, -1 for the register file
+	std::vector<RobEntry> rob;
+	int head = 0, count = 0, order = 0;
+	std::vector<Station> stations; // in program order
+	std::deque<int> lsq;		   // ROB entries of the loads and stores, in program order
+	std::deque<Fetched> fetched;
+	std::vector<Executing> executing;
+	bool fetching = true;
+	int cycle = 0;
+	std::unique_ptr<BranchPredictor> predictor;
+	long long committed = 0, mispredictions = 0, squashed = 0;
+	long long robFull = 0, stationsFull = 0, lsqFull = 0; // cycles dispatch stopped on each
+	// a cycle with a commit is a base cycle, any other goes to what holds up the oldest instruction
+	bool stallAccounting = false;
+	CpiStack cpiStack;
+	int redirectedBy = -1; // pc of the branch or jump that redirected fetch, until the next dispatch
+	// per pc: cycles fetched (IF), in a station (RS), executing (EX) and waiting to commit (ROB), and
+	// the cycles a station or dispatch held it by cause
+	bool profiling = false;
+	PcProfile profile;
+
+	static const int MAX = (1 << 20); // largest program, in bytes of instruction memory
+	PagedMemory data;
+	std::unique_ptr<TraceSink> trace{new TextTraceSink(std::cout)};
+
+	using MIPS_Program::MIPS_Program;
+
+	static bool writesRegister(Opcode op)
+	{
+		return op <= OP_ADDI || op == OP_LW;
+	}
+	static bool accessesMemory(Opcode op)
+	{
+		return op == OP_LW || op == OP_SW;
+	}
+	static UnitKind unitOf(Opcode op)
+	{
+		return op == OP_MUL ? MUL_UNIT : accessesMemory(op) ? MEMORY_UNIT
+															: ALU_UNIT;
+	}
+
+	// the registers an instruction reads: a store's base, then its data
+	static int sourcesOf(const Instruction &ins, int sources[2])
+	{
+		switch (ins.op)
+		{
+		case OP_ADD:
+		case OP_SUB:
+		case OP_MUL:
+		case OP_SLT:
+			sources[0] = ins.r2, sources[1] = ins.r3;
+			return 2;
+		case OP_ADDI:
+		case OP_LW:
+			sources[0] = ins.r2;
+			return 1;
+		case OP_SW:
+			sources[0] = ins.r2, sources[1] = ins.r1;
+			return 2;
+		case OP_BEQ:
+		case OP_BNE:
+			sources[0] = ins.r1, sources[1] = ins.r2;
+			return 2;
+		default:
+			return 0;
+		}
+	}
+
+	int slot(int index)
+	{
+		return (head + index) % config.robSize;
+	}
+
+	// rebuild the rename table from the register file and the entries still in the ROB
+	void renameFromRob()
+	{
+		std::fill(rename, rename + 32, -1);
+		for (int i = 0; i < count; ++i)
+		{
+			const Instruction &ins = program[rob[slot(i)].pc];
+			if (writesRegister(ins.op))
+				rename[ins.r1] = slot(i);
+		}
+	}
+
+	// drop every instruction younger than the given order and everything fetched
+	void squashYounger(int older)
+	{
+		while (count > 0 && rob[slot(count - 1)].order > older)
+			--count, ++squashed;
+		auto younger = [&](int entry)
+		{ return rob[entry].order > older; };
+		stations.erase(std::remove_if(stations.begin(), stations.end(), [&](const Station &station)
+									  { return younger(station.entry); }),
+					   stations.end());
+		executing.erase(std::remove_if(executing.begin(), executing.end(), [&](const Executing &unit)
+									   { return younger(unit.entry); }),
+						executing.end());
+		while (!lsq.empty() && younger(lsq.back()))
+			lsq.pop_back();
+		squashed += fetched.size();
+		fetched.clear();
+		renameFromRob();
+	}
+
+	// the cause of a cycle without a commit: an empty ROB refills, otherwise the oldest instruction waits
+	// for an operand, a unit or its result
+	void chargeStall()
+	{
+		if (count == 0)
+		{
+			cpiStack.charge(redirectedBy != -1 ? CONTROL : PIPELINE_DEPTH, redirectedBy, -1, 1);
+			return;
+		}
+		const RobEntry &entry = rob[head];
+		const Instruction &ins = program[entry.pc];
+		auto station = std::find_if(stations.begin(), stations.end(), [&](const Station &station)
+									{ return station.entry == head; });
+		StallCause cause = ins.op == OP_LW ? LOAD_WAIT : EXECUTE_LATENCY;
+		int reg = -1;
+		if (station != stations.end())
+		{
+			int sources[2], reads = sourcesOf(ins, sources);
+			for (int k = reads - 1; k >= 0; --k)
+				if (station->tag[k] != -1)
+					reg = sources[k];
+			cause = reg != -1 ? DATA_HAZARD : ins.op == OP_LW && !olderStoresExecuted(head) ? LOAD_WAIT : STRUCTURAL;
+		}
+		cpiStack.charge(cause, entry.pc, reg, 1);
+	}
+
+	// commit the oldest finished instructions in program order
+	void commit()
+	{
+		if (stallAccounting && cycle > 0)
+		{
+			if (count > 0 && rob[head].done)
+				cpiStack.charge(BASE, rob[head].pc, -1, 1);
+			else
+				chargeStall();
+		}
+		for (int n = 0; n < config.width && count > 0 && rob[head].done; ++n)
+		{
+			const RobEntry &entry = rob[head];
+			const Instruction &ins = program[entry.pc];
+			++commandCount[entry.pc];
+			if (writesRegister(ins.op))
+			{
+				registers[ins.r1] = entry.value;
+				if (rename[ins.r1] == head)
+					rename[ins.r1] = -1;
+			}
+			if (ins.op == OP_SW)
+				data.writeDelta(entry.address, entry.value);
+			if (accessesMemory(ins.op))
+				lsq.pop_front();
+			head = (head + 1) % config.robSize, --count;
+			++committed;
+		}
+	}
+
+	// a branch finished: fetch resumes after it, or on a mispredict the wrong path is squashed
+	void resolve(const RobEntry &entry)
+	{
+		const Instruction &ins = program[entry.pc];
+		bool taken = entry.value != 0;
+		int next = taken ? ins.target : entry.pc + 1;
+		if (!predictor)
+		{
+			PCcurr = next, fetching = true, redirectedBy = entry.pc;
+			return;
+		}
+		predictor->update(entry.pc, taken);
+		if (taken == entry.predictedTaken)
+			return;
+		++mispredictions;
+		if (profiling)
+			++profile.mispredicts[entry.pc];
+		squashYounger(entry.order);
+		PCcurr = next, fetching = true, redirectedBy = entry.pc;
+	}
+
+	// results of the units finishing this cycle are broadcast to the ROB and the stations, oldest first
+	void complete()
+	{
+		std::sort(executing.begin(), executing.end(), [&](const Executing &a, const Executing &b)
+				  { return rob[a.entry].order < rob[b.entry].order; });
+		for (size_t i = 0; i < executing.size(); ++i)
+		{
+			if (executing[i].finish != cycle)
+				continue;
+			int index = executing[i].entry;
+			RobEntry &entry = rob[index];
+			entry.done = true;
+			for (Station &station : stations)
+				for (int k = 0; k < 2; ++k)
+					if (station.tag[k] == index)
+						station.tag[k] = -1, station.value[k] = entry.value;
+			Opcode op = program[entry.pc].op;
+			if (op == OP_BEQ || op == OP_BNE)
+				resolve(entry); // a squash only removes younger units, which come after this one
+		}
+		executing.erase(std::remove_if(executing.begin(), executing.end(), [&](const Executing &unit)
+									   { return unit.finish <= cycle; }),
+						executing.end());
+	}
+
+	// a load may read once every older store knows its address
+	bool olderStoresExecuted(int index)
+	{
+		for (int entry : lsq)
+		{
+			if (entry == index)
+				return true;
+			if (program[rob[entry].pc].op == OP_SW && !rob[entry].executed)
+				return false;
+		}
+		return true;
+	}
+
+	// the loaded word: the youngest older store to the address forwards its data, otherwise data memory
+	int load(int index, int address)
+	{
+		int value = data.read(address);
+		for (int entry : lsq)
+		{
+			if (entry == index)
+				break;
+			if (program[rob[entry].pc].op == OP_SW && rob[entry].address == address)
+				value = rob[entry].value;
+		}
+		return value;
+	}
+
+	// start the oldest ready instructions on the free units of each kind
+	void execute()
+	{
+		int started[UNIT_KINDS] = {0};
+		for (size_t i = 0; i < stations.size();)
+		{
+			Station &station = stations[i];
+			RobEntry &entry = rob[station.entry];
+			const Instruction &ins = program[entry.pc];
+			UnitKind kind = unitOf(ins.op);
+			bool operands = station.tag[0] == -1 && station.tag[1] == -1;
+			bool ready = operands && started[kind] < config.units[kind];
+			if (!ready || (ins.op == OP_LW && !olderStoresExecuted(station.entry)))
+			{
+				if (profiling)
+					++profile.stalls[entry.pc][!operands ? DATA_HAZARD : !ready ? STRUCTURAL : LOAD_WAIT];
+				++i;
+				continue;
+			}
+			const int *operand = station.value;
+			switch (ins.op)
+			{
+			case OP_ADD:
+				entry.value = operand[0] + operand[1];
+				break;
+			case OP_SUB:
+				entry.value = operand[0] - operand[1];
+				break;
+			case OP_MUL:
+				entry.value = operand[0] * operand[1];
+				break;
+			case OP_SLT:
+				entry.value = operand[0] < operand[1];
+				break;
+			case OP_ADDI:
+				entry.value = operand[0] + ins.imm;
+				break;
+			case OP_LW:
+				entry.address = (operand[0] + ins.imm) / 4, entry.executed = true;
+				entry.value = load(station.entry, entry.address);
+				break;
+			case OP_SW:
+				entry.address = (operand[0] + ins.imm) / 4, entry.executed = true;
+				entry.value = operand[1];
+				break;
+			case OP_BEQ:
+			case OP_BNE:
+				entry.value = (operand[0] == operand[1]) == (ins.op == OP_BEQ);
+				break;
+			default:
+				break;
+			}
+			int latency = ins.op == OP_SW ? 1 : config.latency[kind];
+			executing.push_back({station.entry, cycle + latency});
+			++started[kind];
+			stations.erase(stations.begin() + i);
+		}
+	}
+
+	// dispatch stops at the instruction for want of the structure the counter stands for
+	void dispatchStopped(long long &counter, int pc)
+	{
+		++counter;
+		if (profiling)
+			++profile.stalls[pc][STRUCTURAL];
+	}
+
+	// rename and dispatch the fetched instructions in order while the ROB, the stations and the LSQ have room
+	void dispatch()
+	{
+		for (int n = 0; n < config.width && !fetched.empty(); ++n)
+		{
+			const Fetched &next = fetched.front();
+			const Instruction &ins = program[next.pc];
+			if (count == config.robSize)
+				return dispatchStopped(robFull, next.pc);
+			if (ins.op != OP_J && (int)stations.size() == config.stations)
+				return dispatchStopped(stationsFull, next.pc);
+			if (accessesMemory(ins.op) && (int)lsq.size() == config.lsqSize)
+				return dispatchStopped(lsqFull, next.pc);
+			int index = slot(count++);
+			RobEntry &entry = rob[index];
+			entry = RobEntry();
+			entry.pc = next.pc, entry.order = order++, entry.predictedTaken = next.predictedTaken;
+			redirectedBy = -1;
+			if (ins.op == OP_J || next.predictedTaken)
+				PCcurr = ins.target, fetching = true, redirectedBy = next.pc;
+			if (ins.op == OP_J)
+				entry.done = true;
+			else
+			{
+				Station station;
+				station.entry = index;
+				int sources[2], reads = sourcesOf(ins, sources);
+				for (int k = 0; k < reads; ++k)
+				{
+					int producer = rename[sources[k]];
+					if (producer == -1)
+						station.value[k] = registers[sources[k]];
+					else if (rob[producer].done)
+						station.value[k] = rob[producer].value;
+					else
+						station.tag[k] = producer;
+				}
+				stations.push_back(station);
+			}
+			if (writesRegister(ins.op))
+				rename[ins.r1] = index;
+			if (accessesMemory(ins.op))
+				lsq.push_back(index);
+			fetched.pop_front();
+		}
+	}
+
+	// fetch in sequence; fetch stops at a jump or a branch predicted taken until it is dispatched, and
+	// without a predictor at any branch until it resolves
+	void fetch()
+	{
+		for (int n = 0; n < config.width && fetching && (int)fetched.size() < 2 * config.width && (size_t)PCcurr < program.size(); ++n)
+		{
+			const Instruction &ins = program[PCcurr];
+			Fetched next;
+			next.pc = PCcurr++;
+			bool branch = ins.op == OP_BEQ || ins.op == OP_BNE;
+			if (branch && predictor)
+				next.predictedTaken = predictor->predict(next.pc);
+			if (ins.op == OP_J || (branch && (!predictor || next.predictedTaken)))
+				fetching = false;
+			fetched.push_back(next);
+		}
+	}
+
+	// the instructions in flight stay where they are for the next cycle
+	void occupy()
+	{
+		for (const Fetched &next : fetched)
+			profile.occupy(next.pc, 0, 1);
+		for (const Station &station : stations)
+			profile.occupy(rob[station.entry].pc, 1, 1);
+		for (const Executing &unit : executing)
+			profile.occupy(rob[unit.entry].pc, 2, 1);
+		for (int i = 0; i < count; ++i)
+			if (rob[slot(i)].done)
+				profile.occupy(rob[slot(i)].pc, 3, 1);
+	}
+
+	bool busy()
+	{
+		return count > 0 || !fetched.empty() || (fetching && (size_t)PCcurr < program.size());
+	}
+
+	// run the program, the stages are evaluated from commit back to fetch every cycle
+	void executeCommandsOutOfOrder()
+	{
+		rob.assign(config.robSize, RobEntry());
+		std::fill(rename, rename + 32, -1);
+		PCcurr = 0;
+		cpiStack.reset(program.size());
+		if (profiling)
+			profile.reset(program.size(), {"IF", "RS", "EX", "ROB"});
+		int clockCycles = -1;
+		while (busy() || clockCycles == -1)
+		{
+			cycle = clockCycles + 1;
+			commit();
+			complete();
+			execute();
+			dispatch();
+			fetch();
+			if (profiling)
+				occupy();
+			++clockCycles;
+			printRegistersAndMemoryDelta(clockCycles);
+		}
+		cpiStack.instructions = committed;
+		trace->finish(clockCycles, registers, data);
+	}
+
+	void printStats()
+	{
+		std::cerr << "Instructions committed: " << committed << '\n';
+		std::cerr << "IPC: " << (cycle > 0 ? (double)committed / cycle : 0) << '\n';
+		if (predictor)
+			std::cerr << "Mispredictions: " << mispredictions << '\n';
+		std::cerr << "Instructions squashed: " << squashed << '\n';
+		std::cerr << "Dispatch stalls, ROB full: " << robFull << ", stations full: " << stationsFull << ", LSQ full: " << lsqFull << '\n';
+	}
+
+	// hand the register data and this cycle's memory delta to the trace sink
+	void printRegistersAndMemoryDelta(int clockCycle)
+	{
+		trace->cycle(clockCycle, registers, data);
+		data.clearDeltas();
+	}
+};
+
+#endif
@@ -0,0 +1,1247 @@
+/**
+ * @file MIPS_Pipeline.hpp
+ * @brief In-order pipeline engine shared by the pipelined MIPS_Architecture
+ * variants: the front end depth, the depth of each execute path and the
+ * forwarding network come from a configuration struct, so the cycle loop of
+ * every pipeline is specialised at compile time.
+ *
+ */
+
+#ifndef __MIPS_PIPELINE_HPP__
+#define __MIPS_PIPELINE_HPP__
+
+#include <array>
+#include <algorithm>
+#include <climits>
+#include <deque>
+#include <map>
+#include <memory>
+#include <iostream>
+#include "MIPS_Program.hpp"
+#include "MIPS_Memory.hpp"
+#include "MIPS_Trace.hpp"
+#include "BranchPredictor.hpp"
+#include "MIPS_CpiStack.hpp"
+#include "MIPS_Timeline.hpp"
+#include "MIPS_Profile.hpp"
+
+// where ALU operations read their operands and wait for pending writes
+enum Forwarding
+{
+	NO_FORWARDING, // every instruction waits in ID until its sources are written back
+	WB_TO_EX,	   // ALU operations wait in EX, where a result written back the same cycle is visible
+	MEM_TO_EX	   // results are forwarded from the stage after EX, only the consumer of a load waits
+};
+
+/*
+	a pipeline configuration provides:
+	FETCH_STAGES, DECODE_STAGES: front end ahead of the register read stage (ID).
+		A jump resolves in the last decode stage, or in ID if there is none
+	ALU_DEPTH, MEMORY_DEPTH: stages between EX and WB for ALU operations and for
+		loads and stores, memory is accessed in the last of them
+	SPLIT_MEMORY_PATH: loads and stores take their own path, sharing the register
+		write port with the ALU path. Otherwise both depths describe one path
+	FORWARDING: see Forwarding
+	WRITE_BEFORE_READ: a register written back can be read in the same cycle
+	ISSUE_WIDTH: instructions fetched, decoded and issued per cycle, in order, through
+		one memory port. Every stage then holds that many instructions
+*/
+struct Pipeline5
+{
+	static constexpr int FETCH_STAGES = 1, DECODE_STAGES = 0, ALU_DEPTH = 1, MEMORY_DEPTH = 1, ISSUE_WIDTH = 1;
+	static constexpr bool SPLIT_MEMORY_PATH = false, WRITE_BEFORE_READ = true;
+	static constexpr Forwarding FORWARDING = NO_FORWARDING;
+};
+struct Pipeline5Bypass : Pipeline5
+{
+	static constexpr Forwarding FORWARDING = MEM_TO_EX;
+};
+struct Pipeline5BypassDual : Pipeline5Bypass
+{
+	static constexpr int ISSUE_WIDTH = 2;
+};
+struct Pipeline79
+{
+	static constexpr int FETCH_STAGES = 2, DECODE_STAGES = 2, ALU_DEPTH = 0, MEMORY_DEPTH = 2, ISSUE_WIDTH = 1;
+	static constexpr bool SPLIT_MEMORY_PATH = true, WRITE_BEFORE_READ = false;
+	static constexpr Forwarding FORWARDING = NO_FORWARDING;
+};
+struct Pipeline79Bypass : Pipeline79
+{
+	static constexpr bool WRITE_BEFORE_READ = true;
+	static constexpr Forwarding FORWARDING = WB_TO_EX;
+};
+
+/*
+	the registers with a write in flight. Every instruction that claims its destination holds
+	one bit of held, which stays set in writers[] of that register until the instruction
+	writes back or is squashed, so a release can never free another instruction's claim.
+	readyAt is the first cycle the newest value can be read: NEVER while a writer holds the
+	register, otherwise the latest cycle a released write became visible
+*/
+struct Scoreboard
+{
+	static constexpr int NEVER = INT_MAX;
+	uint64_t writers[32] = {0}, held = 0;
+	int readyAt[32] = {0}, visibleAt[32] = {0};
+
+	// a new writer of the register, the bit it holds
+	uint64_t claim(int reg)
+	{
+		uint64_t bit = ~held & (held + 1);
+		held |= bit, writers[reg] |= bit, readyAt[reg] = NEVER;
+		return bit;
+	}
+
+	// the writer let go of the register, its value can be read from the given cycle
+	void release(int reg, uint64_t bit, int visible)
+	{
+		held &= ~bit, writers[reg] &= ~bit;
+		visibleAt[reg] = std::max(visibleAt[reg], visible);
+		readyAt[reg] = writers[reg] == 0 ? visibleAt[reg] : NEVER;
+	}
+};
+
+template <class Config>
+struct MIPS_Pipeline : MIPS_Program
+{
+	static constexpr int FRONT = Config::FETCH_STAGES + Config::DECODE_STAGES + 1, ID = FRONT - 1;
+	static constexpr int JUMP_STAGE = Config::DECODE_STAGES == 0 ? ID : ID - 1;
+	static constexpr bool SPLIT = Config::SPLIT_MEMORY_PATH;
+	static constexpr Forwarding FORWARDING = Config::FORWARDING;
+	static constexpr int WIDTH = Config::ISSUE_WIDTH;
+	// every stage numbered in a row: the front end, the ALU path, then the memory path when SPLIT
+	static constexpr int ALU_STAGE = FRONT, MEMORY_STAGE = ALU_STAGE + Config::ALU_DEPTH + 2;
+	static constexpr int STAGES = SPLIT ? MEMORY_STAGE + Config::MEMORY_DEPTH + 2 : MEMORY_STAGE;
+	static_assert(WIDTH == 1 || !SPLIT, "the write port arbitration of a split memory path is single issue");
+	static_assert(SPLIT || Config::ALU_DEPTH == Config::MEMORY_DEPTH, "a single path has one depth");
+	static_assert(Config::MEMORY_DEPTH > 0, "memory is accessed in a stage after EX");
+	static_assert(FORWARDING != MEM_TO_EX || Config::ALU_DEPTH > 0, "results are forwarded from a stage between EX and WB");
+
+	/*
+		an instruction in flight:
+		value: the result, loaded word or store data; address: the word index
+		ready: the first cycle a memory access can complete; fetched: the cycle it was fetched
+		started: the first cycle in EX with its sources ready, -1 before; resultAt: the first cycle its result can leave the stage after EX
+		claim: the scoreboard bit held on the destination, 0 if none; thread: the hardware thread it belongs to
+		predictedTaken: the predictor guessed taken
+		followed: fetch already continues at the target; bubbles: fetch cycles lost to this branch or jump
+		cause: why it was last held in a stage, or fetched late; hazard: the register of a data hazard,
+			or the pc of the branch or jump behind a control stall
+	*/
+	struct Latch
+	{
+		bool valid = false;
+		int pc = 0, order = 0, value = 0, address = 0, ready = 0, fetched = 0, bubbles = 0;
+		int started = -1, resultAt = 0, thread = 0;
+		uint64_t claim = 0;
+		bool predictedTaken = false, followed = false;
+		StallCause cause = PIPELINE_DEPTH;
+		int hazard = -1;
+	};
+	struct ControlStats
+	{
+		long long count = 0, bubbles = 0;
+	};
+	// an instruction held in a stage for a cycle
+	struct HeldStall
+	{
+		int stage, pc;
+		StallCause cause;
+	};
+	// a store that left the pipeline and waits for its memory write, which completes at doneAt
+	struct BufferedStore
+	{
+		int address = 0, value = 0, doneAt = 0;
+	};
+	// the instructions in one stage, oldest first: the valid ones always come before the free slots
+	using Stage = std::array<Latch, WIDTH>;
+	// EX, the DEPTH stages after it and WB
+	template <int DEPTH>
+	using Path = std::array<Stage, DEPTH + 2>;
+	// why an instruction stays in ID; for the second of a decoded pair, why the pair split
+	enum Hold
+	{
+		ISSUED,
+		WAITING,	// sources, a free EX slot, or an older branch to resolve
+		DEPENDENCY, // reads a result of an older instruction entering EX in the same cycle
+		MEMORY_PORT // an older load or store takes the memory port in EX
+	};
+
+	/*
+		a hardware thread: its registers, data segment and fetch state. Every thread runs the program
+		from the start and shares the stage latches, the predictor and the BTB with the others
+	*/
+	struct Thread
+	{
+		int registers[32] = {0}, PCcurr = 0;
+		int forwarded[32] = {0}; // newest value of every register, written back or not (MEM_TO_EX)
+		Scoreboard scoreboard;
+		PagedMemory data;
+		std::deque<int> loads;				   // order of the loads fetched and not yet written back, when SPLIT
+		std::deque<int> unresolved;			   // order of the predicted branches in flight
+		std::deque<BufferedStore> storeBuffer; // oldest first
+		bool fetching = true, redirect = false;
+		int target = 0;
+		int redirectedBy = -1;		// pc of the branch or jump that last redirected fetch, until the next fetch
+		long long instructions = 0; // fetched and not squashed
+	};
+	enum FetchPolicy
+	{
+		ROUND_ROBIN,	 // the threads take turns
+		FEWEST_IN_FLIGHT // the thread with the fewest instructions in fetch, decode and ID
+	};
+
+	std::vector<Thread> threads = std::vector<Thread>(1);
+	FetchPolicy fetchPolicy = ROUND_ROBIN;
+	int lastFetched = 0; // the thread fetch served last
+	std::array<Stage, FRONT> front;
+	Path<Config::ALU_DEPTH> alu;
+	Path<Config::MEMORY_DEPTH> memory; // loads and stores, when SPLIT
+	int order = 0;
+	int cycle = 0;			   // the cycle being evaluated
+	int cycles = 0;			   // total cycles of the last run
+	bool progressed = false;   // whether anything moved this cycle
+	int memoryLatency = 1;	   // cycles a load or store spends in its memory access stage
+	// per opcode: cycles from the start of EX until the result can be forwarded or written back, and
+	// cycles before EX takes the next instruction: 1 for a pipelined unit, the latency for an unpipelined one;
+	// an unknown mnemonic decodes to OP_INVALID and passes through in a single cycle
+	int latency[OP_INVALID + 1] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+	int interval[OP_INVALID + 1] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+	bool skipIdleCycles = true; // jump over cycles in which nothing can move
+	// stores leave the memory stage into the buffer and write memory one at a time behind the pipeline,
+	// loads read the newest buffered store to their address; with 0 entries stores write in the memory stage
+	int storeBufferSize = 0;
+	long long loadsAccessed = 0, forwardedLoads = 0, storeBufferStalls = 0;
+	// with a predictor fetch continues past beq/bne and j, otherwise it stops until they resolve
+	std::unique_ptr<BranchPredictor> predictor;
+	long long branches = 0, mispredictions = 0, mispredictPenalty = 0, decodeRedirects = 0, squashed = 0;
+	// a hit redirects fetch to the target of a jump or predicted taken branch as it leaves fetch
+	std::unique_ptr<BranchTargetBuffer> btb;
+	long long btbHits = 0;
+	bool resolveBranchesInID = false; // beq/bne compare in ID instead of EX
+	std::vector<ControlStats> control; // per instruction, over the branches and jumps that retired
+	long long issueCycles[WIDTH + 1] = {0}; // cycles with an instruction in ID, by how many issued
+	std::map<std::pair<int, int>, std::array<long long, 4>> splitPairs; // decoded pairs that issued apart, by Hold
+	// every cycle goes to the instruction completing in it, the cycles since the one before to what held it up
+	bool stallAccounting = false;
+	CpiStack cpiStack;
+	int lastRetired = 0;
+	std::vector<std::array<long long, STALL_CAUSES>> stageStalls; // instruction cycles held in each stage, by cause
+	std::vector<HeldStall> stalls;								  // the instructions held this cycle
+	std::unique_ptr<KanataTimeline> timeline;					  // every instruction's stages and stalls, if set
+	bool profiling = false;										  // cycles per stage, stalls and mispredictions by pc
+	PcProfile profile;
+
+	static const int MAX = (1 << 20); // largest program, in bytes of instruction memory
+	std::unique_ptr<TraceSink> trace{new TextTraceSink(std::cout)};
+
+	using MIPS_Program::MIPS_Program;
+
+	Thread &of(const Latch &latch)
+	{
+		return threads[latch.thread];
+	}
+
+	static bool writesRegister(Opcode op)
+	{
+		return op <= OP_ADDI || op == OP_LW;
+	}
+	static bool accessesMemory(Opcode op)
+	{
+		return op == OP_LW || op == OP_SW;
+	}
+	static bool controls(Opcode op)
+	{
+		return op == OP_BEQ || op == OP_BNE || op == OP_J;
+	}
+	// whether ins reads the register the older instruction writes
+	static bool dependsOn(const Instruction &ins, const Instruction &older)
+	{
+		if (!writesRegister(older.op))
+			return false;
+		switch (ins.op)
+		{
+		case OP_ADD:
+		case OP_SUB:
+		case OP_MUL:
+		case OP_SLT:
+			return ins.r2 == older.r1 || ins.r3 == older.r1;
+		case OP_ADDI:
+		case OP_LW:
+			return ins.r2 == older.r1;
+		case OP_SW:
+		case OP_BEQ:
+		case OP_BNE:
+			return ins.r1 == older.r1 || ins.r2 == older.r1;
+		default:
+			return false;
+		}
+	}
+
+	static int occupied(const Stage &stage)
+	{
+		int count = 0;
+		while (count < WIDTH && stage[count].valid)
+			++count;
+		return count;
+	}
+	// close the gaps left by instructions that moved on
+	static void compact(Stage &stage)
+	{
+		int count = 0;
+		for (int slot = 0; slot < WIDTH; ++slot)
+			if (stage[slot].valid)
+				stage[count++] = stage[slot];
+		for (; count < WIDTH; ++count)
+			stage[count].valid = false;
+	}
+	bool usesMemoryPort(const Stage &stage)
+	{
+		for (const Latch &latch : stage)
+			if (latch.valid && accessesMemory(program[latch.pc].op))
+				return true;
+		return false;
+	}
+
+	// calls visit(latch) for every latch of the front end and both paths
+	template <typename Visitor>
+	void forEachLatch(Visitor visit)
+	{
+		for (auto &stage : front)
+			std::for_each(stage.begin(), stage.end(), visit);
+		for (auto &stage : alu)
+			std::for_each(stage.begin(), stage.end(), visit);
+		if (SPLIT)
+			for (auto &stage : memory)
+				std::for_each(stage.begin(), stage.end(), visit);
+	}
+	bool resolvesInID(Opcode op)
+	{
+		return resolveBranchesInID && (op == OP_BEQ || op == OP_BNE);
+	}
+
+	// ALU operations wait for their sources in ID unless a forwarding network delivers them to EX
+	static bool waitsInID(Opcode op)
+	{
+		return FORWARDING == NO_FORWARDING || (FORWARDING == WB_TO_EX && accessesMemory(op));
+	}
+
+	// the first cycle every register the instruction reads can be read, Scoreboard::NEVER while one is claimed.
+	// A forwarded store's data is only needed in memory
+	static int readyCycle(const Thread &thread, const Instruction &ins)
+	{
+		const int *readyAt = thread.scoreboard.readyAt;
+		switch (ins.op)
+		{
+		case OP_ADD:
+		case OP_SUB:
+		case OP_MUL:
+		case OP_SLT:
+			return std::max(readyAt[ins.r2], readyAt[ins.r3]);
+		case OP_ADDI:
+		case OP_LW:
+			return readyAt[ins.r2];
+		case OP_SW:
+			return FORWARDING == MEM_TO_EX ? readyAt[ins.r2] : std::max(readyAt[ins.r2], readyAt[ins.r1]);
+		case OP_BEQ:
+		case OP_BNE:
+			return std::max(readyAt[ins.r1], readyAt[ins.r2]);
+		default:
+			return 0;
+		}
+	}
+	bool sourcesReady(const Thread &thread, const Instruction &ins)
+	{
+		return readyCycle(thread, ins) <= cycle;
+	}
+	bool registerReady(const Thread &thread, int reg)
+	{
+		return thread.scoreboard.readyAt[reg] <= cycle;
+	}
+
+	// the first register the instruction reads that has a write pending, -1 if none
+	int pendingSource(const Latch &latch)
+	{
+		const Instruction &ins = program[latch.pc];
+		int sources[2] = {ins.r2, ins.op == OP_SW || ins.op == OP_BEQ || ins.op == OP_BNE ? ins.r1 : ins.r3};
+		int reads = ins.op == OP_ADDI || ins.op == OP_LW ? 1 : ins.op == OP_J ? 0 : 2;
+		for (int k = 0; k < reads; ++k)
+			if (!registerReady(of(latch), sources[k]) || unclaimedWrite(latch.thread, sources[k]))
+				return sources[k];
+		return -1;
+	}
+
+	// the instruction cannot move on this cycle for the given reason
+	static bool stall(Latch &latch, StallCause cause, int hazard = -1)
+	{
+		latch.cause = cause, latch.hazard = hazard;
+		return false;
+	}
+	// the instructions left in a stage were held this cycle, by what holds the given one
+	void held(Stage &stage, const Latch &blocker, int index)
+	{
+		StallCause cause = blocker.cause;
+		int hazard = blocker.hazard;
+		for (Latch &latch : stage)
+			if (latch.valid)
+			{
+				latch.cause = cause, latch.hazard = hazard;
+				if (stallAccounting || profiling)
+					stalls.push_back({index, latch.pc, cause});
+				if (timeline)
+					timeline->stall(latch.order, CpiStack::NAMES[cause]);
+			}
+	}
+
+	void claim(Latch &latch)
+	{
+		latch.claim = of(latch).scoreboard.claim(program[latch.pc].r1);
+	}
+	// the value can be read in this cycle if the register file is written first, otherwise in the next
+	void release(Latch &latch, int visible)
+	{
+		of(latch).scoreboard.release(program[latch.pc].r1, latch.claim, visible);
+		latch.claim = 0;
+	}
+
+	void writeBack(Latch &latch)
+	{
+		const Instruction &ins = program[latch.pc];
+		of(latch).registers[ins.r1] = latch.value;
+		if (latch.claim)
+			release(latch, Config::WRITE_BEFORE_READ ? cycle : cycle + 1);
+	}
+
+	// fetched down a predicted path that is not confirmed yet
+	bool speculative(const Latch &latch)
+	{
+		const std::deque<int> &unresolved = of(latch).unresolved;
+		return !unresolved.empty() && latch.order > unresolved.front();
+	}
+
+	// drop every instruction of the thread fetched after the given one, releasing the registers they claimed
+	void squashYounger(int thread, int order)
+	{
+		Thread &t = threads[thread];
+		auto squash = [&](Latch &latch)
+		{
+			if (!latch.valid || latch.thread != thread || latch.order <= order)
+				return;
+			if (latch.claim)
+				release(latch, cycle);
+			latch.valid = false;
+			++squashed, --t.instructions;
+			if (timeline)
+				timeline->squash(latch.order);
+		};
+		forEachLatch(squash);
+		while (!t.loads.empty() && t.loads.back() > order)
+			t.loads.pop_back();
+		while (!t.unresolved.empty() && t.unresolved.back() > order)
+			t.unresolved.pop_back();
+		progressed = true;
+	}
+
+	// fetch restarts at next after a branch or jump, the cycles since it was fetched are its bubbles
+	void refetch(Latch &latch, int next)
+	{
+		Thread &t = of(latch);
+		t.redirect = true, t.target = next, t.fetching = true, t.redirectedBy = latch.pc;
+		latch.bubbles += cycle - latch.fetched - 1;
+	}
+
+	// a jump, or a branch predicted taken, redirects fetch once it leaves decode and its target is known
+	void decoded(Latch &latch)
+	{
+		const Instruction &ins = program[latch.pc];
+		if (ins.op == OP_J && btb)
+			btb->update(latch.pc, ins.target);
+		if ((ins.op != OP_J && !latch.predictedTaken) || latch.followed)
+			return;
+		if (predictor)
+			squashYounger(latch.thread, latch.order), ++decodeRedirects;
+		latch.followed = true;
+		refetch(latch, ins.target);
+	}
+
+	// a branch resolved in EX, or in ID: fetch restarts after it, or on a mispredict the wrong path is squashed
+	void resolve(Latch &latch, bool taken)
+	{
+		const Instruction &ins = program[latch.pc];
+		if (taken && btb)
+			btb->update(latch.pc, ins.target);
+		if (!predictor)
+		{
+			refetch(latch, taken ? ins.target : latch.pc + 1);
+			return;
+		}
+		predictor->update(latch.pc, taken);
+		of(latch).unresolved.pop_front();
+		if (taken != latch.predictedTaken)
+		{
+			++mispredictions;
+			if (profiling)
+				++profile.mispredicts[latch.pc];
+		}
+		if (taken == latch.followed)
+			return;
+		if (taken != latch.predictedTaken)
+			mispredictPenalty += cycle - latch.fetched - 1;
+		else
+			++decodeRedirects;
+		squashYounger(latch.thread, latch.order);
+		refetch(latch, taken ? ins.target : latch.pc + 1);
+	}
+
+	// whether an ALU instruction of the thread writes the register without a claim yet: it is still in
+	// EX or, with MEM_TO_EX, in the stage after it, where it has not been forwarded yet
+	bool unclaimedWrite(int thread, int reg)
+	{
+		for (int stage = 0; stage <= (FORWARDING == MEM_TO_EX ? 1 : 0); ++stage)
+			for (const Latch &latch : alu[stage])
+				if (latch.valid && latch.thread == thread && !latch.claim && writesRegister(program[latch.pc].op) && program[latch.pc].r1 == reg)
+					return true;
+		return false;
+	}
+	// whether the comparator in ID can read the register: no write is pending
+	bool comparable(int thread, int reg)
+	{
+		return registerReady(threads[thread], reg) && !unclaimedWrite(thread, reg);
+	}
+
+	// whether an ALU instruction of the thread still in EX uses the register the load writes: it reads
+	// its sources on leaving EX unless it read them in ID, and its write has to come first
+	bool usedInEX(int thread, const Instruction &load)
+	{
+		for (const Latch &latch : alu[0])
+		{
+			const Instruction &older = program[latch.pc];
+			if (latch.valid && latch.thread == thread && ((!waitsInID(older.op) && dependsOn(older, load)) || (writesRegister(older.op) && older.r1 == load.r1)))
+				return true;
+		}
+		return false;
+	}
+
+	// whether the instruction in EX has what it needs to start executing
+	bool canStart(const Latch &latch)
+	{
+		const Instruction &ins = program[latch.pc];
+		return resolvesInID(ins.op) || waitsInID(ins.op) || sourcesReady(of(latch), ins);
+	}
+
+	bool branchTaken(const Instruction &ins, const int *operands)
+	{
+		return (operands[ins.r1] == operands[ins.r2]) == (ins.op == OP_BEQ);
+	}
+
+	// the result of an ALU operation or the address of a load or store
+	void compute(Latch &latch, const int *operands)
+	{
+		const Instruction &ins = program[latch.pc];
+		switch (ins.op)
+		{
+		case OP_ADD:
+			latch.value = operands[ins.r2] + operands[ins.r3];
+			break;
+		case OP_SUB:
+			latch.value = operands[ins.r2] - operands[ins.r3];
+			break;
+		case OP_MUL:
+			latch.value = operands[ins.r2] * operands[ins.r3];
+			break;
+		case OP_SLT:
+			latch.value = operands[ins.r2] < operands[ins.r3];
+			break;
+		case OP_ADDI:
+			latch.value = operands[ins.r2] + ins.imm;
+			break;
+		case OP_LW:
+		case OP_SW:
+			latch.address = (operands[ins.r2] + ins.imm) / 4;
+			break;
+		default:
+			break;
+		}
+	}
+
+	// EX: compute the result, address or branch outcome, false if the instruction has to wait.
+	// An instruction that waited for its sources in ID read them there
+	bool execute(Latch &latch)
+	{
+		const Instruction &ins = program[latch.pc];
+		Thread &t = of(latch);
+		if (resolvesInID(ins.op))
+			return true;
+		if (!waitsInID(ins.op))
+		{
+			if (!sourcesReady(t, ins))
+				return stall(latch, DATA_HAZARD, pendingSource(latch));
+			if (writesRegister(ins.op) && (FORWARDING != MEM_TO_EX || ins.op == OP_LW))
+				claim(latch);
+		}
+		// a forwarded result is readable once it leaves the stage after EX, which a long latency delays
+		latch.resultAt = std::max(latch.started + latency[ins.op], cycle + 1);
+		if (FORWARDING == MEM_TO_EX && ins.op <= OP_ADDI)
+			t.scoreboard.release(ins.r1, t.scoreboard.claim(ins.r1), latch.resultAt);
+		const int *operands = FORWARDING == MEM_TO_EX ? t.forwarded : t.registers;
+		if (!waitsInID(ins.op))
+			compute(latch, operands);
+		if (ins.op == OP_BEQ || ins.op == OP_BNE)
+			resolve(latch, branchTaken(ins, operands));
+		return true;
+	}
+
+	// the stages after EX, the last of which accesses memory; false if the instruction has to wait
+	bool access(Latch &latch, int stage, int depth)
+	{
+		const Instruction &ins = program[latch.pc];
+		Thread &t = of(latch);
+		std::deque<BufferedStore> &storeBuffer = t.storeBuffer;
+		if (stage == 1 && cycle < latch.resultAt)
+			return stall(latch, EXECUTE_LATENCY);
+		if (FORWARDING == MEM_TO_EX && stage == 1 && ins.op <= OP_ADDI)
+			t.forwarded[ins.r1] = latch.value;
+		if (stage != depth)
+			return true;
+		if (ins.op == OP_LW)
+		{
+			auto hit = std::find_if(storeBuffer.rbegin(), storeBuffer.rend(), [&](const BufferedStore &store)
+									{ return store.address == latch.address; });
+			if (hit != storeBuffer.rend())
+				latch.value = hit->value, ++forwardedLoads;
+			else if (cycle < latch.ready)
+				return stall(latch, LOAD_WAIT);
+			else
+				latch.value = t.data.read(latch.address);
+			++loadsAccessed;
+			if (FORWARDING == MEM_TO_EX)
+				t.forwarded[ins.r1] = latch.value, release(latch, cycle + 1);
+		}
+		else if (ins.op == OP_SW)
+		{
+			if (storeBufferSize == 0 && cycle < latch.ready)
+				return stall(latch, STORE_WAIT);
+			if (FORWARDING == MEM_TO_EX)
+			{
+				if (!registerReady(t, ins.r1))
+					return stall(latch, DATA_HAZARD, ins.r1);
+				latch.value = t.forwarded[ins.r1];
+			}
+			if (storeBufferSize == 0)
+				t.data.writeDelta(latch.address, latch.value);
+			else if ((int)storeBuffer.size() == storeBufferSize)
+			{
+				++storeBufferStalls;
+				return stall(latch, STORE_WAIT);
+			}
+			else
+			{
+				int start = storeBuffer.empty() ? cycle : std::max(cycle, storeBuffer.back().doneAt);
+				storeBuffer.push_back({latch.address, latch.value, start + memoryLatency});
+			}
+		}
+		return true;
+	}
+
+	// the buffered stores whose memory write completed leave the buffers, oldest first
+	void drainStores()
+	{
+		for (Thread &t : threads)
+			while (!t.storeBuffer.empty() && t.storeBuffer.front().doneAt <= cycle)
+			{
+				t.data.writeDelta(t.storeBuffer.front().address, t.storeBuffer.front().value);
+				t.storeBuffer.pop_front();
+				progressed = true;
+			}
+	}
+
+	// whether the instruction leaves its stage of a path this cycle, with at most one load or store in the
+	// stage that accesses memory. An instruction leaves EX once its unit's initiation interval has passed
+	// since it started
+	template <int DEPTH>
+	bool leaves(Latch &latch, int stage, const Stage &next)
+	{
+		Opcode op = program[latch.pc].op;
+		if (stage == 0 && latch.started == -1)
+			return stall(latch, DATA_HAZARD, pendingSource(latch));
+		if (stage == 0 && cycle < latch.started + interval[op] - 1)
+			return stall(latch, EXECUTE_LATENCY);
+		if (stage + 1 == DEPTH && accessesMemory(op) && usesMemoryPort(next))
+			return stall(latch, STRUCTURAL);
+		return stage == 0 ? execute(latch) : access(latch, stage, DEPTH);
+	}
+
+	// move the instructions of a path, whose EX stage has the given number, one stage towards WB while
+	// the next stage has room, oldest first
+	template <int DEPTH>
+	void advance(Path<DEPTH> &path, int first)
+	{
+		for (int stage = DEPTH; stage >= 0; --stage)
+		{
+			Stage &here = path[stage], &next = path[stage + 1];
+			if (stage == 0)
+				for (Latch &latch : here)
+					if (latch.valid && latch.started == -1 && canStart(latch))
+						latch.started = cycle;
+			const Latch *blocker = &next[0];
+			for (int slot = 0, free = occupied(next); slot < WIDTH && here[slot].valid && free < WIDTH; ++slot, ++free)
+			{
+				Latch &latch = here[slot];
+				if (!leaves<DEPTH>(latch, stage, next))
+				{
+					blocker = &latch;
+					break;
+				}
+				next[free] = latch;
+				next[free].ready = cycle + memoryLatency;
+				latch.valid = false;
+				progressed = true;
+				if (timeline)
+					timeline->stage(latch.order, stageName(first + stage + 1));
+			}
+			held(here, *blocker, first + stage);
+			compact(here);
+		}
+	}
+
+	// the instruction leaves WB. The first to do so in a cycle takes it as its base cycle, and the cycles
+	// since the last one are charged to what held up the oldest instruction in flight: a result on the
+	// shorter path of a split pipeline can leave before an older load or store
+	void retire(Latch &latch)
+	{
+		++commandCount[latch.pc];
+		if (controls(program[latch.pc].op))
+			++control[latch.pc].count, control[latch.pc].bubbles += latch.bubbles;
+		if (stallAccounting && cycle != lastRetired)
+		{
+			const Latch *oldest = &latch;
+			forEachLatch([&](const Latch &other)
+						 { if (other.valid && other.order < oldest->order) oldest = &other; });
+			int pc = oldest->cause == CONTROL && oldest->hazard != -1 ? oldest->hazard : oldest->pc;
+			cpiStack.charge(oldest->cause, pc, oldest->cause == DATA_HAZARD ? oldest->hazard : -1, cycle - lastRetired - 1);
+			cpiStack.charge(BASE, latch.pc, -1, 1);
+			lastRetired = cycle;
+		}
+		cpiStack.instructions += stallAccounting;
+		latch.valid = false;
+		if (timeline)
+			timeline->retire(latch.order);
+	}
+
+	// WB of both paths through one register write port: the older of two writes goes first, an ALU
+	// result may not overtake an older load of its thread still in flight, nor a load an older ALU
+	// result still waiting for its latency
+
+	void writeBackStage()
+	{
+		if (!SPLIT)
+		{
+			for (Latch &latch : alu.back())
+			{
+				if (!latch.valid)
+					continue;
+				progressed = true;
+				if (writesRegister(program[latch.pc].op))
+					writeBack(latch);
+				retire(latch);
+			}
+			return;
+		}
+		Latch &wa = alu.back()[0], &wm = memory.back()[0];
+		progressed |= wa.valid || wm.valid;
+		bool aluWrites = wa.valid && writesRegister(program[wa.pc].op);
+		const std::deque<int> &loads = of(wa).loads;
+		bool afterLoads = loads.empty() || wa.order < loads.front();
+		bool aluReady = cycle >= wa.resultAt;
+		bool load = wm.valid && program[wm.pc].op == OP_LW;
+		// an older ALU result of a thread with no load ahead of it takes the port before a load, even
+		// while it waits for its latency
+		bool aluFirst = load && aluWrites && wa.order < wm.order && afterLoads;
+		bool memoryLeaves = wm.valid && !aluFirst;
+		bool aluLeaves = wa.valid && (!aluWrites || (afterLoads && aluReady && !(load && memoryLeaves)));
+		if (memoryLeaves && load)
+			of(wm).loads.pop_front(), writeBack(wm);
+		if (aluLeaves && aluWrites)
+			writeBack(wa);
+		// when both leave, the older one takes the cycle
+		bool memoryFirst = memoryLeaves && (!aluLeaves || wm.order < wa.order);
+		if (memoryFirst)
+			retire(wm);
+		if (aluLeaves)
+			retire(wa);
+		if (memoryLeaves && !memoryFirst)
+			retire(wm);
+		// a load waits for the port while an older ALU result is not ready
+		if (wa.valid)
+			stall(wa, aluReady ? WRITE_PORT : EXECUTE_LATENCY), held(alu.back(), wa, MEMORY_STAGE - 1);
+		if (wm.valid)
+			stall(wm, WRITE_PORT), held(memory.back(), wm, STAGES - 1);
+	}
+
+	// ID: issue to the EX stage of the instruction's path once it has room and the sources are ready.
+	// An instruction joining older ones of its thread in EX may not read their results, nor any share the memory port
+	Hold issue(Latch &latch)
+	{
+		const Instruction &ins = program[latch.pc];
+		Thread &t = of(latch);
+		Stage &ex = SPLIT && accessesMemory(ins.op) ? memory[0] : alu[0];
+		int free = occupied(ex);
+		if (free == WIDTH)
+			return stall(latch, ex[0].cause, ex[0].hazard), WAITING;
+		for (int slot = 0; slot < free; ++slot)
+		{
+			const Instruction &older = program[ex[slot].pc];
+			if (ex[slot].thread == latch.thread && dependsOn(ins, older))
+				return stall(latch, DATA_HAZARD, older.r1), DEPENDENCY;
+			if (accessesMemory(ins.op) && accessesMemory(older.op))
+				return stall(latch, STRUCTURAL), MEMORY_PORT;
+		}
+		// loads and stores leave ID once every older branch resolved: they never touch memory on a wrong
+		// path, and a claim taken here cannot hold up the branch it waits for
+		if (accessesMemory(ins.op) && speculative(latch))
+			return stall(latch, CONTROL), WAITING;
+		// a load on the other path may not write a register before an older instruction in EX reads or writes it
+		if (SPLIT && ins.op == OP_LW && usedInEX(latch.thread, ins))
+			return stall(latch, DATA_HAZARD, ins.r1), WAITING;
+		if (resolvesInID(ins.op) && !(comparable(latch.thread, ins.r1) && comparable(latch.thread, ins.r2)))
+			return stall(latch, DATA_HAZARD, comparable(latch.thread, ins.r1) ? ins.r2 : ins.r1), WAITING;
+		if (waitsInID(ins.op))
+		{
+			// an older ALU instruction on the other path may not have claimed the source yet
+			if (!sourcesReady(t, ins) || unclaimedWrite(latch.thread, ins.r2) || (ins.op == OP_SW && unclaimedWrite(latch.thread, ins.r1)))
+				return stall(latch, DATA_HAZARD, pendingSource(latch)), WAITING;
+			if (writesRegister(ins.op))
+				claim(latch);
+			compute(latch, t.registers);
+		}
+		if (ins.op == OP_SW && FORWARDING != MEM_TO_EX)
+			latch.value = t.registers[ins.r1];
+		ex[free] = latch;
+		latch.valid = false;
+		if (timeline)
+			timeline->stage(latch.order, stageName(&ex == &alu[0] ? ALU_STAGE : MEMORY_STAGE));
+		if (resolvesInID(ins.op))
+			resolve(ex[free], branchTaken(ins, FORWARDING == MEM_TO_EX ? t.forwarded : t.registers));
+		else if (JUMP_STAGE == ID)
+			decoded(ex[free]);
+		progressed = true;
+		return ISSUED;
+	}
+
+	// issue the instructions in ID in order, stopping at the first that has to wait
+	void issueStage()
+	{
+		Stage &id = front[ID];
+		if (!id[0].valid)
+			return;
+		int issued = 0, first = id[0].pc;
+		for (int slot = 0; slot < WIDTH && id[slot].valid; ++slot, ++issued)
+		{
+			Hold hold = issue(id[slot]);
+			if (hold == ISSUED)
+				continue;
+			if (slot > 0)
+				++splitPairs[{first, id[slot].pc}][hold];
+			held(id, id[slot], ID);
+			break;
+		}
+		compact(id);
+		++issueCycles[issued];
+	}
+
+	// leaving fetch: the predictor and the BTB choose where fetch continues. Without a predictor a
+	// branch stops fetching until it resolves, and a jump until it is decoded, unless the BTB knows its target
+	void fetched(Latch &latch)
+	{
+		const Instruction &ins = program[latch.pc];
+		Thread &t = of(latch);
+		++t.PCcurr;
+		bool branch = ins.op == OP_BEQ || ins.op == OP_BNE;
+		if (branch && predictor)
+			latch.predictedTaken = predictor->predict(latch.pc), t.unresolved.push_back(latch.order), ++branches;
+		int hit = btb && (ins.op == OP_J || latch.predictedTaken) ? btb->lookup(latch.pc) : -1;
+		if (hit != -1)
+			t.PCcurr = hit, latch.followed = true, ++btbHits;
+		else if (ins.op == OP_J || (branch && !predictor))
+			t.fetching = false;
+		if (SPLIT && ins.op == OP_LW)
+			t.loads.push_back(latch.order);
+	}
+
+	// the front end: every stage passes on as many instructions as the next one has room for
+	void advanceFront()
+	{
+		for (int stage = ID - 1; stage >= 0; --stage)
+		{
+			Stage &here = front[stage], &next = front[stage + 1];
+			for (int slot = 0, free = occupied(next); slot < WIDTH && here[slot].valid && free < WIDTH; ++slot, ++free)
+			{
+				Latch &latch = here[slot];
+				if (stage == 0)
+					fetched(latch);
+				next[free] = latch;
+				latch.valid = false;
+				progressed = true;
+				if (timeline)
+					timeline->stage(latch.order, stageName(stage + 1));
+				if (stage == JUMP_STAGE)
+					decoded(next[free]);
+			}
+			held(here, next[0], stage);
+			compact(here);
+		}
+	}
+
+	// whether fetch can serve the thread this cycle
+	bool fetchable(const Thread &t)
+	{
+		return t.fetching && (size_t)t.PCcurr < program.size();
+	}
+	// the thread fetch serves this cycle, the next one after the last served that can fetch or, with
+	// FEWEST_IN_FLIGHT, the first of those with the fewest instructions ahead of EX; -1 if none can
+	int fetchThread()
+	{
+		auto inFront = [&](int thread)
+		{
+			int count = 0;
+			for (auto &stage : front)
+				for (const Latch &latch : stage)
+					count += latch.valid && latch.thread == thread;
+			return count;
+		};
+		int count = threads.size(), chosen = -1, fewest = INT_MAX;
+		for (int i = 1; i <= count; ++i)
+		{
+			int thread = (lastFetched + i) % count;
+			if (!fetchable(threads[thread]))
+				continue;
+			if (fetchPolicy == ROUND_ROBIN)
+				return thread;
+			int inFlight = inFront(thread);
+			if (inFlight < fewest)
+				chosen = thread, fewest = inFlight;
+		}
+		return chosen;
+	}
+
+	// fetch the next instructions of one thread in sequence, a fetch group ends after a branch or jump
+	void fetch()
+	{
+		int thread = fetchThread();
+		if (thread == -1)
+			return;
+		Thread &t = threads[thread];
+		lastFetched = thread;
+		int redirectedBy = t.redirectedBy;
+		t.redirectedBy = -1;
+		for (int slot = 0; slot < WIDTH && (size_t)(t.PCcurr + slot) < program.size(); ++slot)
+		{
+			Latch &latch = front[0][slot];
+			latch = Latch();
+			latch.valid = true, latch.pc = t.PCcurr + slot, latch.order = order++, latch.fetched = cycle, latch.thread = thread;
+			if (redirectedBy != -1)
+				latch.cause = CONTROL, latch.hazard = redirectedBy;
+			if (timeline)
+				timeline->fetch(latch.order, thread, latch.pc, disassembly(latch.pc), stageName(0));
+			++t.instructions;
+			progressed = true;
+			if (controls(program[latch.pc].op))
+				break;
+		}
+	}
+
+	bool busy()
+	{
+		bool any = false;
+		for (const Thread &t : threads)
+			any |= !t.storeBuffer.empty();
+		forEachLatch([&](const Latch &latch)
+					 { any |= latch.valid; });
+		return any;
+	}
+
+	/*
+		handle all exit codes:
+		0: correct execution
+		1: register provided is incorrect
+		2: invalid label
+		3: unaligned or invalid address
+		4: syntax error
+		5: commands exceed memory limit
+	*/
+	void handleExit(exit_code code, int cycleCount)
+	{
+		std::cout << '\n';
+		switch (code)
+		{
+		case 1:
+			std::cerr << "Invalid register provided or syntax error in providing register\n";
+			break;
+		case 2:
+			std::cerr << "Label used not defined or defined too many times\n";
+			break;
+		case 3:
+			std::cerr << "Unaligned or invalid memory address specified\n";
+			break;
+		case 4:
+			std::cerr << "Syntax error encountered\n";
+			break;
+		case 5:
+			std::cerr << "Memory limit exceeded\n";
+			break;
+		default:
+			break;
+		}
+		if (code != 0)
+		{
+			std::cerr << "Error encountered at:\n";
+			for (auto &s : commands[threads[0].PCcurr])
+				std::cerr << s << ' ';
+			std::cerr << '\n';
+		}
+		std::cout << "\nFollowing are the non-zero data values:\n";
+		threads[0].data.forEachNonZero([](uint32_t i, int value)
+							{ std::cout << 4 * i << '-' << 4 * i + 3 << std::hex << ": " << value << '\n'
+										<< std::dec; });
+		std::cout << "\nTotal number of cycles: " << cycleCount << '\n';
+		std::cout << "Count of instructions executed:\n";
+		for (int i = 0; i < (int)commands.size(); ++i)
+		{
+			std::cout << commandCount[i] << " times:\t";
+			for (auto &s : commands[i])
+				std::cout << s << ' ';
+			std::cout << '\n';
+		}
+	}
+
+	// the first cycle after the current one in which a waiting memory access completes, a result's
+	// latency ends or a unit takes its next instruction, -1 if none
+	int nextEvent()
+	{
+		int next = -1;
+		auto earliest = [&](const Latch &latch)
+		{
+			if (!latch.valid)
+				return;
+			int issueAt = latch.started == -1 ? 0 : latch.started + interval[program[latch.pc].op] - 1;
+			for (int event : {latch.ready, latch.resultAt, issueAt})
+				if (event > cycle + 1 && (next == -1 || event < next))
+					next = event;
+		};
+		forEachLatch(earliest);
+		for (const Thread &t : threads)
+			if (!t.storeBuffer.empty() && t.storeBuffer.front().doneAt > cycle + 1 && (next == -1 || t.storeBuffer.front().doneAt < next))
+				next = t.storeBuffer.front().doneAt;
+		return next;
+	}
+
+	/*
+		run the program through the pipeline, stages are evaluated from WB back to fetch every cycle.
+		A cycle in which nothing moved only repeats until a memory access or a long latency completes, so with
+		skipIdleCycles the cycles up to it are handed to the trace as idle instead of evaluated.
+		The trace follows thread 0
+	*/
+	void executeCommandsPipelined()
+	{
+		for (Thread &t : threads)
+			t.PCcurr = 0;
+		control.assign(program.size(), ControlStats());
+		cpiStack.reset(program.size());
+		stageStalls.assign(STAGES, std::array<long long, STALL_CAUSES>());
+		if (profiling)
+		{
+			std::vector<std::string> names;
+			for (int stage = 0; stage < STAGES; ++stage)
+				names.push_back(stageName(stage));
+			profile.reset(program.size(), names);
+		}
+		lastRetired = 0;
+		int clockCycles = -1;
+		while (busy() || clockCycles == -1)
+		{
+			cycle = clockCycles + 1;
+			progressed = false;
+			stalls.clear();
+			if (timeline)
+				timeline->cycle(cycle);
+			drainStores();
+			writeBackStage();
+			if (SPLIT)
+				advance<Config::MEMORY_DEPTH>(memory, MEMORY_STAGE);
+			advance<Config::ALU_DEPTH>(alu, ALU_STAGE);
+			issueStage();
+			advanceFront();
+			for (Thread &t : threads)
+				if (t.redirect)
+					t.PCcurr = t.target, t.redirect = false;
+			if (!front[0][0].valid)
+				fetch();
+			++clockCycles;
+			printRegistersAndMemoryDelta(clockCycles);
+			int next = skipIdleCycles && !progressed ? nextEvent() : -1;
+			// the skipped cycles hold the same instructions as this one
+			long long repeated = next == -1 ? 1 : next - clockCycles;
+			for (const HeldStall &stall : stalls)
+			{
+				stageStalls[stall.stage][stall.cause] += repeated;
+				if (profiling)
+					profile.stalls[stall.pc][stall.cause] += repeated;
+			}
+			if (profiling)
+				occupy(repeated);
+			if (next != -1)
+			{
+				trace->idle(clockCycles + 1, next - 1, threads[0].registers, threads[0].data);
+				clockCycles = next - 1;
+			}
+		}
+		cycles = clockCycles;
+		if (stallAccounting)
+			cpiStack.charge(DRAIN, -1, -1, clockCycles - lastRetired);
+		trace->finish(clockCycles, threads[0].registers, threads[0].data);
+	}
+
+	void printBranchStats()
+	{
+		if (predictor)
+		{
+			std::cerr << "Branches predicted: " << branches << '\n';
+			std::cerr << "Mispredictions: " << mispredictions << '\n';
+			std::cerr << "Mispredict penalty cycles: " << mispredictPenalty << '\n';
+			std::cerr << "Redirects in decode: " << decodeRedirects << '\n';
+			std::cerr << "Instructions squashed: " << squashed << '\n';
+		}
+		if (btb)
+			std::cerr << "BTB hits: " << btbHits << '\n';
+		std::cerr << "Bubbles per branch and jump:\n";
+		for (int i = 0; i < (int)control.size(); ++i)
+		{
+			if (control[i].count == 0)
+				continue;
+			std::cerr << control[i].count << " times, " << control[i].bubbles << " bubbles:\t";
+			for (auto &s : commands[i])
+				std::cerr << s << ' ';
+			std::cerr << '\n';
+		}
+	}
+
+	void printThreadStats()
+	{
+		long long total = 0;
+		for (int i = 0; i < (int)threads.size(); ++i)
+		{
+			std::cerr << "Thread " << i << " instructions: " << threads[i].instructions << '\n';
+			total += threads[i].instructions;
+		}
+		std::cerr << "Instructions per cycle: " << (cycles > 0 ? (double)total / cycles : 0) << '\n';
+	}
+
+	// the instructions in flight stay in their stages for the next cycles
+	void occupy(long long cycles)
+	{
+		auto stay = [&](const Stage &stage, int index)
+		{
+			for (const Latch &latch : stage)
+				if (latch.valid)
+					profile.occupy(latch.pc, index, cycles);
+		};
+		for (int stage = 0; stage < FRONT; ++stage)
+			stay(front[stage], stage);
+		for (int stage = 0; stage < (int)alu.size(); ++stage)
+			stay(alu[stage], ALU_STAGE + stage);
+		if (SPLIT)
+			for (int stage = 0; stage < (int)memory.size(); ++stage)
+				stay(memory[stage], MEMORY_STAGE + stage);
+	}
+
+	// the name of a numbered stage, as in the course pipelines
+	static std::string stageName(int index)
+	{
+		auto numbered = [](const char *name, int count, int number)
+		{ return count == 1 ? std::string(name) : name + std::to_string(number); };
+		if (index < Config::FETCH_STAGES)
+			return numbered("IF", Config::FETCH_STAGES, index + 1);
+		if (index < ID)
+			return numbered("DEC", Config::DECODE_STAGES, index - Config::FETCH_STAGES + 1);
+		if (index == ID)
+			return "ID";
+		bool onAluPath = index < MEMORY_STAGE;
+		int depth = onAluPath ? Config::ALU_DEPTH : Config::MEMORY_DEPTH, stage = index - (onAluPath ? ALU_STAGE : MEMORY_STAGE);
+		std::string path = SPLIT ? (onAluPath ? "1" : "2") : "";
+		if (stage == 0)
+			return SPLIT ? "ALU" + path : "EX";
+		if (stage == depth + 1)
+			return "WB" + path;
+		return numbered("MEM", depth, stage);
+	}
+
+	std::string disassembly(int pc)
+	{
+		std::string text;
+		for (auto &s : commands[pc])
+			if (!s.empty())
+				text += (text.empty() ? "" : " ") + std::string(s);
+		return text;
+	}
+
+	void printStallStats()
+	{
+		cpiStack.print(commands);
+		std::cerr << "Stall cycles by stage:\n";
+		for (int stage = 0; stage < STAGES; ++stage)
+		{
+			std::string causes;
+			for (int cause = 0; cause < STALL_CAUSES; ++cause)
+				if (stageStalls[stage][cause] > 0)
+					causes += (causes.empty() ? "" : ", ") + std::string(CpiStack::NAMES[cause]) + ' ' + std::to_string(stageStalls[stage][cause]);
+			if (!causes.empty())
+				std::cerr << stageName(stage) << ": " << causes << '\n';
+		}
+	}
+
+	void printMemoryStats()
+	{
+		std::cerr << "Loads: " << loadsAccessed << '\n';
+		std::cerr << "Loads forwarded from the store buffer: " << forwardedLoads << " ("
+				  << (loadsAccessed > 0 ? 100.0 * forwardedLoads / loadsAccessed : 0) << "%)\n";
+		std::cerr << "Store buffer full stall cycles: " << storeBufferStalls << '\n';
+	}
+
+	void printIssueStats()
+	{
+		for (int issued = WIDTH; issued >= 0; --issued)
+			std::cerr << "Cycles issuing " << issued << ": " << issueCycles[issued] << '\n';
+		static const char *reasons[] = {"", "waiting", "dependency", "memory port"};
+		std::cerr << "Decoded pairs that issued apart:\n";
+		for (auto &pair : splitPairs)
+			for (int hold = WAITING; hold <= MEMORY_PORT; ++hold)
+			{
+				if (pair.second[hold] == 0)
+					continue;
+				std::cerr << pair.second[hold] << " times, " << reasons[hold] << ":\t";
+				for (auto &s : commands[pair.first.first])
+					std::cerr << s << ' ';
+				std::cerr << "| ";
+				for (auto &s : commands[pair.first.second])
+					std::cerr << s << ' ';
+				std::cerr << '\n';
+			}
+	}
+
+	// the entry point the course drivers call
+	void executeCommandsUnpipelined()
+	{
+		executeCommandsPipelined();
+	}
+
+	// hand the register data and this cycle's memory delta of thread 0 to the trace sink
+	void printRegistersAndMemoryDelta(int clockCycle)
+	{
+		trace->cycle(clockCycle, threads[0].registers, threads[0].data);
+		for (Thread &t : threads)
+			t.data.clearDeltas();
+	}
+};
+
+#endif
@@ -9,238 +9,159 @@
 
 #include <unordered_map>
 #include <string>
-#include <functional>
 #include <vector>
 #include <fstream>
-#include <exception>
 #include <iostream>
-#include <boost/tokenizer.hpp>
+#include "MIPS_Program.hpp"
+#include "MIPS_Memory.hpp"
+#include "MIPS_Trace.hpp"
 
-struct MIPS_Architecture
+struct MIPS_Architecture : MIPS_Program
 {
 	int registers[32] = {0}, PCcurr = 0, PCnext;
-	std::unordered_map<std::string, std::function<int(MIPS_Architecture &, std::string, std::string, std::string)>> instructions;
-	std::unordered_map<std::string, int> registerMap, address;
-	static const int MAX = (1 << 20);
-	int data[MAX >> 2] = {0};
-	std::unordered_map<int, int> memoryDelta;
-	std::vector<std::vector<std::string>> commands;
-	std::vector<int> commandCount;
-	enum exit_code
-	{
-		SUCCESS = 0,
-		INVALID_REGISTER,
-		INVALID_LABEL,
-		INVALID_ADDRESS,
-		SYNTAX_ERROR,
-		MEMORY_ERROR
-	};
+	static const int MAX = (1 << 20); // largest program, in bytes of instruction memory
+	PagedMemory data;
+	std::unique_ptr<TraceSink> trace{new TextTraceSink(std::cout)};
 
-	// constructor to initialise the instruction set
-	MIPS_Architecture(std::ifstream &file)
-	{
-		instructions = {{"add", &MIPS_Architecture::add}, {"sub", &MIPS_Architecture::sub}, {"mul", &MIPS_Architecture::mul}, {"beq", &MIPS_Architecture::beq}, {"bne", &MIPS_Architecture::bne}, {"slt", &MIPS_Architecture::slt}, {"j", &MIPS_Architecture::j}, {"lw", &MIPS_Architecture::lw}, {"sw", &MIPS_Architecture::sw}, {"addi", &MIPS_Architecture::addi}};
-
-		for (int i = 0; i < 32; ++i)
-			registerMap["$" + std::to_string(i)] = i;
-		registerMap["$zero"] = 0;
-		registerMap["$at"] = 1;
-		registerMap["$v0"] = 2;
-		registerMap["$v1"] = 3;
-		for (int i = 0; i < 4; ++i)
-			registerMap["$a" + std::to_string(i)] = i + 4;
-		for (int i = 0; i < 8; ++i)
-			registerMap["$t" + std::to_string(i)] = i + 8, registerMap["$s" + std::to_string(i)] = i + 16;
-		registerMap["$t8"] = 24;
-		registerMap["$t9"] = 25;
-		registerMap["$k0"] = 26;
-		registerMap["$k1"] = 27;
-		registerMap["$gp"] = 28;
-		registerMap["$sp"] = 29;
-		registerMap["$s8"] = 30;
-		registerMap["$ra"] = 31;
-
-		constructCommands(file);
-		commandCount.assign(commands.size(), 0);
-	}
+	using MIPS_Program::MIPS_Program;
 
 	// perform add operation
-	int add(std::string r1, std::string r2, std::string r3)
+	int add(const Instruction &ins)
 	{
-		return op(r1, r2, r3, [&](int a, int b)
+		return op(ins, [](int a, int b)
 				  { return a + b; });
 	}
 
 	// perform subtraction operation
-	int sub(std::string r1, std::string r2, std::string r3)
+	int sub(const Instruction &ins)
 	{
-		return op(r1, r2, r3, [&](int a, int b)
+		return op(ins, [](int a, int b)
 				  { return a - b; });
 	}
 
 	// perform multiplication operation
-	int mul(std::string r1, std::string r2, std::string r3)
+	int mul(const Instruction &ins)
 	{
-		return op(r1, r2, r3, [&](int a, int b)
+		return op(ins, [](int a, int b)
 				  { return a * b; });
 	}
 
 	// perform the binary operation
-	int op(std::string r1, std::string r2, std::string r3, std::function<int(int, int)> operation)
+	template <typename Operation>
+	int op(const Instruction &ins, Operation operation)
 	{
-		if (!checkRegisters({r1, r2, r3}) || registerMap[r1] == 0)
-			return 1;
-		registers[registerMap[r1]] = operation(registers[registerMap[r2]], registers[registerMap[r3]]);
+		registers[ins.r1] = operation(registers[ins.r2], registers[ins.r3]);
 		PCnext = PCcurr + 1;
 		return 0;
 	}
 
 	// perform the beq operation
-	int beq(std::string r1, std::string r2, std::string label)
+	int beq(const Instruction &ins)
 	{
-		return bOP(r1, r2, label, [](int a, int b)
+		return bOP(ins, [](int a, int b)
 				   { return a == b; });
 	}
 
 	// perform the bne operation
-	int bne(std::string r1, std::string r2, std::string label)
+	int bne(const Instruction &ins)
 	{
-		return bOP(r1, r2, label, [](int a, int b)
+		return bOP(ins, [](int a, int b)
 				   { return a != b; });
 	}
 
 	// implements beq and bne by taking the comparator
-	int bOP(std::string r1, std::string r2, std::string label, std::function<bool(int, int)> comp)
+	template <typename Comparator>
+	int bOP(const Instruction &ins, Comparator comp)
 	{
-		if (!checkLabel(label))
-			return 4;
-		if (address.find(label) == address.end() || address[label] == -1)
-			return 2;
-		if (!checkRegisters({r1, r2}))
-			return 1;
-		PCnext = comp(registers[registerMap[r1]], registers[registerMap[r2]]) ? address[label] : PCcurr + 1;
+		PCnext = comp(registers[ins.r1], registers[ins.r2]) ? ins.target : PCcurr + 1;
 		return 0;
 	}
 
 	// implements slt operation
-	int slt(std::string r1, std::string r2, std::string r3)
+	int slt(const Instruction &ins)
 	{
-		if (!checkRegisters({r1, r2, r3}) || registerMap[r1] == 0)
-			return 1;
-		registers[registerMap[r1]] = registers[registerMap[r2]] < registers[registerMap[r3]];
+		registers[ins.r1] = registers[ins.r2] < registers[ins.r3];
 		PCnext = PCcurr + 1;
 		return 0;
 	}
 
 	// perform the jump operation
-	int j(std::string label, std::string unused1 = "", std::string unused2 = "")
+	int j(const Instruction &ins)
 	{
-		if (!checkLabel(label))
-			return 4;
-		if (address.find(label) == address.end() || address[label] == -1)
-			return 2;
-		PCnext = address[label];
+		PCnext = ins.target;
 		return 0;
 	}
 
 	// perform load word operation
-	int lw(std::string r, std::string location, std::string unused1 = "")
+	int lw(const Instruction &ins)
 	{
-		if (!checkRegister(r) || registerMap[r] == 0)
-			return 1;
-		int address = locateAddress(location);
+		int address = locateAddress(ins);
 		if (address < 0)
 			return abs(address);
-		registers[registerMap[r]] = data[address];
+		registers[ins.r1] = data.read(address);
 		PCnext = PCcurr + 1;
 		return 0;
 	}
 
 	// perform store word operation
-	int sw(std::string r, std::string location, std::string unused1 = "")
+	int sw(const Instruction &ins)
 	{
-		if (!checkRegister(r))
-			return 1;
-		int address = locateAddress(location);
+		int address = locateAddress(ins);
 		if (address < 0)
 			return abs(address);
-		if (data[address] != registers[registerMap[r]])
-			memoryDelta[address] = registers[registerMap[r]];
-		data[address] = registers[registerMap[r]];
+		if (data.read(address) != registers[ins.r1])
+			data.writeDelta(address, registers[ins.r1]);
 		PCnext = PCcurr + 1;
 		return 0;
 	}
 
-	int locateAddress(std::string location)
+	// word index of the decoded offset(register) operand, negative exit code if it is invalid
+	int locateAddress(const Instruction &ins)
 	{
-		if (location.back() == ')')
-		{
-			try
-			{
-				int lparen = location.find('('), offset = stoi(lparen == 0 ? "0" : location.substr(0, lparen));
-				std::string reg = location.substr(lparen + 1);
-				reg.pop_back();
-				if (!checkRegister(reg))
-					return -3;
-				int address = registers[registerMap[reg]] + offset;
-				if (address % 4 || address < int(4 * commands.size()) || address >= MAX)
-					return -3;
-				return address / 4;
-			}
-			catch (std::exception &e)
-			{
-				return -4;
-			}
-		}
-		try
-		{
-			int address = stoi(location);
-			if (address % 4 || address < int(4 * commands.size()) || address >= MAX)
-				return -3;
-			return address / 4;
-		}
-		catch (std::exception &e)
-		{
-			return -4;
-		}
+		uint32_t address = (uint32_t)registers[ins.r2] + (uint32_t)ins.imm;
+		if (address % 4 || address < 4 * program.size())
+			return -3;
+		return address / 4;
 	}
 
 	// perform add immediate operation
-	int addi(std::string r1, std::string r2, std::string num)
-	{
-		if (!checkRegisters({r1, r2}) || registerMap[r1] == 0)
-			return 1;
-		try
-		{
-			registers[registerMap[r1]] = registers[registerMap[r2]] + stoi(num);
-			PCnext = PCcurr + 1;
-			return 0;
-		}
-		catch (std::exception &e)
-		{
-			return 4;
-		}
-	}
-
-	// checks if label is valid
-	inline bool checkLabel(std::string str)
+	int addi(const Instruction &ins)
 	{
-		return str.size() > 0 && isalpha(str[0]) && all_of(++str.begin(), str.end(), [](char c)
-														   { return (bool)isalnum(c); }) &&
-			   instructions.find(str) == instructions.end();
-	}
-
-	// checks if the register is a valid one
-	inline bool checkRegister(std::string r)
-	{
-		return registerMap.find(r) != registerMap.end();
+		registers[ins.r1] = registers[ins.r2] + ins.imm;
+		PCnext = PCcurr + 1;
+		return 0;
 	}
 
-	// checks if all of the registers are valid or not
-	bool checkRegisters(std::vector<std::string> regs)
+	// execute a decoded instruction, operands were validated when decoding
+	int execute(const Instruction &ins)
 	{
-		return std::all_of(regs.begin(), regs.end(), [&](std::string r)
-						   { return checkRegister(r); });
+		if (ins.error != SUCCESS)
+			return ins.error;
+		switch (ins.op)
+		{
+		case OP_ADD:
+			return add(ins);
+		case OP_SUB:
+			return sub(ins);
+		case OP_MUL:
+			return mul(ins);
+		case OP_SLT:
+			return slt(ins);
+		case OP_ADDI:
+			return addi(ins);
+		case OP_LW:
+			return lw(ins);
+		case OP_SW:
+			return sw(ins);
+		case OP_BEQ:
+			return beq(ins);
+		case OP_BNE:
+			return bne(ins);
+		case OP_J:
+			return j(ins);
+		default:
+			return SYNTAX_ERROR;
+		}
 	}
 
 	/*
@@ -284,118 +205,441 @@ struct MIPS_Architecture
 		}
 	}
 
-	// parse the command assuming correctly formatted MIPS instruction (or label)
-	void parseCommand(std::string line)
+	// execute the commands sequentially (no pipelining)
+	void executeCommandsUnpipelined()
 	{
-		// strip until before the comment begins
-		line = line.substr(0, line.find('#'));
-		std::vector<std::string> command;
-		boost::tokenizer<boost::char_separator<char>> tokens(line, boost::char_separator<char>(", \t"));
-		for (auto &s : tokens)
-			command.push_back(s);
-		// empty line or a comment only line
-		if (command.empty())
+		if (program.size() >= MAX / 4)
+		{
+			handleExit(MEMORY_ERROR, 0);
 			return;
-		else if (command.size() == 1)
+		}
+
+		int clockCycles = 0;
+		while (PCcurr < (int)program.size())
 		{
-			std::string label = command[0].back() == ':' ? command[0].substr(0, command[0].size() - 1) : "?";
-			if (address.find(label) == address.end())
-				address[label] = commands.size();
-			else
-				address[label] = -1;
-			command.clear();
+			++clockCycles;
+			exit_code ret = (exit_code)execute(program[PCcurr]);
+			if (ret != SUCCESS)
+			{
+				trace->finish(clockCycles, registers, data);
+				handleExit(ret, clockCycles);
+				return;
+			}
+			++commandCount[PCcurr];
+			PCcurr = PCnext;
+			printRegistersAndMemoryDelta(clockCycles);
 		}
-		else if (command[0].back() == ':')
+		trace->finish(clockCycles, registers, data);
+		handleExit(SUCCESS, clockCycles);
+	}
+
+	// superinstructions the fast engine executes as one host operation
+	enum fusion_kind
+	{
+		FUSE_NONE = 0,
+		FUSE_SLT_BRANCH,
+		FUSE_ADDI_BRANCH,
+		FUSE_LW_ADD_SW,
+		FUSION_KINDS
+	};
+	bool fuse = true;
+	std::vector<uint8_t> fusion;
+	long long fusionSites[FUSION_KINDS] = {0}, fusionCount[FUSION_KINDS] = {0};
+
+	// recognise slt+beq/bne, addi+beq/bne and lw+add+sw read-modify-write starting at each PC
+	void findFusions()
+	{
+		fusion.assign(program.size(), FUSE_NONE);
+		std::fill(fusionSites, fusionSites + FUSION_KINDS, 0);
+		auto valid = [&](int pc, Opcode op)
+		{ return pc < (int)program.size() && program[pc].error == SUCCESS && program[pc].op == op; };
+		for (int i = 0; i < (int)program.size(); ++i)
 		{
-			std::string label = command[0].substr(0, command[0].size() - 1);
-			if (address.find(label) == address.end())
-				address[label] = commands.size();
-			else
-				address[label] = -1;
-			command = std::vector<std::string>(command.begin() + 1, command.end());
+			const Instruction *ins = &program[i];
+			if (valid(i, OP_SLT) && (valid(i + 1, OP_BEQ) || valid(i + 1, OP_BNE)))
+				fusion[i] = FUSE_SLT_BRANCH;
+			else if (valid(i, OP_ADDI) && (valid(i + 1, OP_BEQ) || valid(i + 1, OP_BNE)))
+				fusion[i] = FUSE_ADDI_BRANCH;
+			// the loaded word is an add operand, the sum is stored back to the same address and the base survives
+			else if (valid(i, OP_LW) && valid(i + 1, OP_ADD) && valid(i + 2, OP_SW) &&
+					 (ins[1].r2 == ins[0].r1 || ins[1].r3 == ins[0].r1) && ins[2].r1 == ins[1].r1 &&
+					 ins[2].r2 == ins[0].r2 && ins[2].imm == ins[0].imm && ins[0].r1 != ins[0].r2 && ins[1].r1 != ins[0].r2)
+				fusion[i] = FUSE_LW_ADD_SW;
+			++fusionSites[fusion[i]];
 		}
-		else if (command[0].find(':') != std::string::npos)
+	}
+
+	/*
+		execute the commands sequentially without per-cycle output, for fast-forwarding
+		and producing reference state. Operands were validated when decoding, so each
+		instruction jumps straight to the handler of the next one (direct threading
+		with computed goto); only the memory bounds are still checked at run time.
+		With fuse set, common idioms found by findFusions run as a single handler.
+		Prints the final registers and returns the number of executed instructions.
+	*/
+	long long executeCommandsFast()
+	{
+		if (program.size() >= MAX / 4)
 		{
-			int idx = command[0].find(':');
-			std::string label = command[0].substr(0, idx);
-			if (address.find(label) == address.end())
-				address[label] = commands.size();
-			else
-				address[label] = -1;
-			command[0] = command[0].substr(idx + 1);
+			handleExit(MEMORY_ERROR, 0);
+			return 0;
 		}
-		else if (command[1][0] == ':')
+
+		long long executed = 0;
+		int *reg = registers, *count = commandCount.data();
+		const int size = program.size();
+		const uint32_t textEnd = 4 * size;
+		const Instruction *code = program.data(), *ins;
+		int pc = PCcurr;
+		uint32_t address;
+		exit_code ret = SUCCESS;
+#if defined(__GNUC__)
+		static void *const handlers[] = {&&op_add, &&op_sub, &&op_mul, &&op_slt, &&op_addi, &&op_lw, &&op_sw, &&op_beq, &&op_bne, &&op_j, &&op_invalid};
+		static void *const fusedHandlers[] = {nullptr, &&fuse_slt_branch, &&fuse_addi_branch, &&fuse_lw_add_sw};
+		if (fuse && fusion.size() != program.size())
+			findFusions();
+		// one handler address per PC, plus the exit reached by falling off (or jumping to) the end.
+		// The instructions covered by a superinstruction keep their own handlers for jumps into them.
+		std::vector<void *> threaded(size + 1);
+		for (int i = 0; i < size; ++i)
+			threaded[i] = code[i].error != SUCCESS ? &&op_invalid : fuse && fusion[i] != FUSE_NONE ? fusedHandlers[fusion[i]] : handlers[code[i].op];
+		threaded[size] = &&done;
+
+#define DISPATCH()        \
+	do                    \
+	{                     \
+		ins = code + pc;  \
+		goto *threaded[pc]; \
+	} while (0)
+#define NEXT(target)    \
+	do                  \
+	{                   \
+		++count[pc];    \
+		++executed;     \
+		pc = (target);  \
+		DISPATCH();     \
+	} while (0)
+// retire the current instruction of a superinstruction and move on to the next one in it
+#define STEP()       \
+	do               \
+	{                \
+		++count[pc]; \
+		++executed;  \
+		++pc;        \
+		++ins;       \
+	} while (0)
+
+		DISPATCH();
+	op_add:
+		reg[ins->r1] = reg[ins->r2] + reg[ins->r3];
+		NEXT(pc + 1);
+	op_sub:
+		reg[ins->r1] = reg[ins->r2] - reg[ins->r3];
+		NEXT(pc + 1);
+	op_mul:
+		reg[ins->r1] = reg[ins->r2] * reg[ins->r3];
+		NEXT(pc + 1);
+	op_slt:
+		reg[ins->r1] = reg[ins->r2] < reg[ins->r3];
+		NEXT(pc + 1);
+	op_addi:
+		reg[ins->r1] = reg[ins->r2] + ins->imm;
+		NEXT(pc + 1);
+	op_lw:
+		address = (uint32_t)reg[ins->r2] + (uint32_t)ins->imm;
+		if (address % 4 || address < textEnd)
+			goto bad_address;
+		reg[ins->r1] = data.read(address / 4);
+		NEXT(pc + 1);
+	op_sw:
+		address = (uint32_t)reg[ins->r2] + (uint32_t)ins->imm;
+		if (address % 4 || address < textEnd)
+			goto bad_address;
+		data.write(address / 4, reg[ins->r1]);
+		NEXT(pc + 1);
+	op_beq:
+		NEXT(reg[ins->r1] == reg[ins->r2] ? ins->target : pc + 1);
+	op_bne:
+		NEXT(reg[ins->r1] != reg[ins->r2] ? ins->target : pc + 1);
+	op_j:
+		NEXT(ins->target);
+	fuse_slt_branch:
+		++fusionCount[FUSE_SLT_BRANCH];
+		reg[ins->r1] = reg[ins->r2] < reg[ins->r3];
+		STEP();
+		NEXT((reg[ins->r1] == reg[ins->r2]) == (ins->op == OP_BEQ) ? ins->target : pc + 1);
+	fuse_addi_branch:
+		++fusionCount[FUSE_ADDI_BRANCH];
+		reg[ins->r1] = reg[ins->r2] + ins->imm;
+		STEP();
+		NEXT((reg[ins->r1] == reg[ins->r2]) == (ins->op == OP_BEQ) ? ins->target : pc + 1);
+	fuse_lw_add_sw:
+		address = (uint32_t)reg[ins->r2] + (uint32_t)ins->imm;
+		if (address % 4 || address < textEnd)
+			goto bad_address;
+		++fusionCount[FUSE_LW_ADD_SW];
+		reg[ins->r1] = data.read(address / 4);
+		STEP();
+		reg[ins->r1] = reg[ins->r2] + reg[ins->r3];
+		data.write(address / 4, reg[ins->r1]);
+		STEP();
+		NEXT(pc + 1);
+	op_invalid:
+		ret = ins->error != SUCCESS ? (exit_code)ins->error : SYNTAX_ERROR;
+		goto done;
+	bad_address:
+		ret = INVALID_ADDRESS;
+		goto done;
+#undef STEP
+#undef NEXT
+#undef DISPATCH
+	done:
+#else
+		// portable fallback: a switch over the decoded opcode
+		while (pc < size)
 		{
-			if (address.find(command[0]) == address.end())
-				address[command[0]] = commands.size();
-			else
-				address[command[0]] = -1;
-			command[1] = command[1].substr(1);
-			if (command[1] == "")
-				command.erase(command.begin(), command.begin() + 2);
+			PCcurr = pc;
+			ins = code + pc;
+			if ((ret = (exit_code)execute(*ins)) != SUCCESS)
+				break;
+			++count[pc];
+			++executed;
+			pc = PCnext;
+		}
+		(void)address, (void)textEnd, (void)reg;
+#endif
+		PCcurr = pc;
+		if (ret != SUCCESS)
+		{
+			trace->finish(executed + 1, registers, data);
+			handleExit(ret, executed + 1);
+			return executed;
+		}
+		printRegistersAndMemoryDelta(executed);
+		trace->finish(executed, registers, data);
+		handleExit(SUCCESS, executed);
+		return executed;
+	}
+
+	// print which superinstructions fired in the last fast run
+	void printFusionReport()
+	{
+		static const char *names[] = {"", "slt+beq/bne", "addi+beq/bne", "lw+add+sw"};
+		static const int lengths[] = {1, 2, 2, 3};
+		long long total = 0;
+		for (int c : commandCount)
+			total += c;
+		std::cerr << "Superinstruction\tsites\tfired\tinstructions covered\n";
+		for (int k = FUSE_NONE + 1; k < FUSION_KINDS; ++k)
+			std::cerr << names[k] << '\t' << fusionSites[k] << '\t' << fusionCount[k] << '\t' << fusionCount[k] * lengths[k]
+					  << " (" << (total ? 100.0 * fusionCount[k] * lengths[k] / total : 0) << "%)\n";
+	}
+
+	// host handler of one translated instruction, returns its exit code
+	typedef int (*BlockOp)(MIPS_Architecture &, const Instruction &);
+
+	// a straight-line run of the program translated into host handlers
+	struct TranslatedBlock
+	{
+		int start, end;											// covers PCs [start, end)
+		std::vector<std::pair<BlockOp, const Instruction *>> ops; // body, excluding the terminating branch
+		const Instruction *branch = nullptr;					// terminating beq/bne/j, if any
+		TranslatedBlock *next[2] = {nullptr, nullptr};			// chained successors: fall through, taken
+		long long executions = 0;
+	};
+	std::unordered_map<int, TranslatedBlock> blockCache;
+	std::vector<bool> leader;
+	long long blockTranslations = 0, blockCacheHits = 0, blockChains = 0;
+
+	// mark the PCs that start a basic block: labels and the instruction after a branch or jump
+	void findLeaders()
+	{
+		leader.assign(program.size() + 1, false);
+		leader[0] = true;
+		for (auto &p : address)
+			if (p.second >= 0 && p.second <= (int)program.size())
+				leader[p.second] = true;
+		for (int i = 0; i < (int)program.size(); ++i)
+			if (program[i].op == OP_BEQ || program[i].op == OP_BNE || program[i].op == OP_J)
+				leader[i + 1] = true;
+	}
+
+	// translate the basic block starting at pc into a sequence of specialised handlers
+	TranslatedBlock translateBlock(int pc)
+	{
+		TranslatedBlock block;
+		block.start = pc;
+		for (; pc < (int)program.size(); ++pc)
+		{
+			if (pc != block.start && leader[pc])
+				break;
+			const Instruction &ins = program[pc];
+			BlockOp handler;
+			if (ins.error != SUCCESS)
+				handler = [](MIPS_Architecture &m, const Instruction &i)
+				{ return i.error; };
+			else if (ins.op == OP_BEQ || ins.op == OP_BNE || ins.op == OP_J)
+			{
+				block.branch = &ins;
+				++pc;
+				break;
+			}
 			else
-				command.erase(command.begin(), command.begin() + 1);
+				switch (ins.op)
+				{
+				case OP_ADD:
+					handler = [](MIPS_Architecture &m, const Instruction &i)
+					{ m.registers[i.r1] = m.registers[i.r2] + m.registers[i.r3]; return 0; };
+					break;
+				case OP_SUB:
+					handler = [](MIPS_Architecture &m, const Instruction &i)
+					{ m.registers[i.r1] = m.registers[i.r2] - m.registers[i.r3]; return 0; };
+					break;
+				case OP_MUL:
+					handler = [](MIPS_Architecture &m, const Instruction &i)
+					{ m.registers[i.r1] = m.registers[i.r2] * m.registers[i.r3]; return 0; };
+					break;
+				case OP_SLT:
+					handler = [](MIPS_Architecture &m, const Instruction &i)
+					{ m.registers[i.r1] = m.registers[i.r2] < m.registers[i.r3]; return 0; };
+					break;
+				case OP_ADDI:
+					handler = [](MIPS_Architecture &m, const Instruction &i)
+					{ m.registers[i.r1] = m.registers[i.r2] + i.imm; return 0; };
+					break;
+				case OP_LW:
+					handler = [](MIPS_Architecture &m, const Instruction &i)
+					{
+						int address = m.locateAddress(i);
+						if (address < 0)
+							return -address;
+						m.registers[i.r1] = m.data.read(address);
+						return 0;
+					};
+					break;
+				default:
+					handler = [](MIPS_Architecture &m, const Instruction &i)
+					{
+						int address = m.locateAddress(i);
+						if (address < 0)
+							return -address;
+						m.data.write(address, m.registers[i.r1]);
+						return 0;
+					};
+					break;
+				}
+			block.ops.emplace_back(handler, &ins);
+			if (ins.error != SUCCESS)
+			{
+				++pc;
+				break;
+			}
 		}
-		if (command.empty())
-			return;
-		if (command.size() > 4)
-			for (int i = 4; i < (int)command.size(); ++i)
-				command[3] += " " + command[i];
-		command.resize(4);
-		commands.push_back(command);
+		block.end = pc;
+		return block;
 	}
 
-	// construct the commands vector from the input file
-	void constructCommands(std::ifstream &file)
+	// find the block starting at pc, translating it on a miss
+	TranslatedBlock *lookupBlock(int pc)
 	{
-		std::string line;
-		while (getline(file, line))
-			parseCommand(line);
-		file.close();
+		auto it = blockCache.find(pc);
+		if (it != blockCache.end())
+		{
+			++blockCacheHits;
+			return &it->second;
+		}
+		++blockTranslations;
+		return &blockCache.emplace(pc, translateBlock(pc)).first->second;
 	}
 
-	// execute the commands sequentially (no pipelining)
-	void executeCommandsUnpipelined()
+	/*
+		execute the commands through a basic-block translation cache, without per-cycle output.
+		Blocks are translated once and cached by start PC; a block remembers its successors,
+		so hot loops chain from block to block without going back to the cache lookup.
+		Instruction counts are added per block rather than per instruction.
+		Prints the final registers and returns the number of executed instructions.
+	*/
+	long long executeCommandsBlockCached()
 	{
-		if (commands.size() >= MAX / 4)
+		if (program.size() >= MAX / 4)
 		{
 			handleExit(MEMORY_ERROR, 0);
-			return;
+			return 0;
 		}
 
-		int clockCycles = 0;
-		while (PCcurr < commands.size())
+		if (leader.size() != program.size() + 1)
+			findLeaders();
+		exit_code ret = SUCCESS;
+		long long executed = 0;
+		TranslatedBlock *block = PCcurr < (int)program.size() ? lookupBlock(PCcurr) : nullptr;
+		while (block != nullptr)
 		{
-			++clockCycles;
-			std::vector<std::string> &command = commands[PCcurr];
-			if (instructions.find(command[0]) == instructions.end())
+			int i = 0, n = block->ops.size();
+			for (; i < n; ++i)
+				if ((ret = (exit_code)block->ops[i].first(*this, *block->ops[i].second)) != SUCCESS)
+					break;
+			if (ret != SUCCESS)
 			{
-				handleExit(SYNTAX_ERROR, clockCycles);
-				return;
+				// account for the part of the block that did execute
+				for (int k = 0; k < i; ++k)
+					++commandCount[block->start + k];
+				executed += i;
+				PCcurr = block->start + i;
+				break;
 			}
-			exit_code ret = (exit_code) instructions[command[0]](*this, command[1], command[2], command[3]);
-			if (ret != SUCCESS)
+			++block->executions;
+			int taken = 0, nextPC = block->end;
+			if (block->branch != nullptr)
 			{
-				handleExit(ret, clockCycles);
-				return;
+				const Instruction &b = *block->branch;
+				taken = b.op == OP_J || ((registers[b.r1] == registers[b.r2]) == (b.op == OP_BEQ));
+				if (taken)
+					nextPC = b.target;
 			}
-			++commandCount[PCcurr];
-			PCcurr = PCnext;
-			printRegistersAndMemoryDelta(clockCycles);
+			if (nextPC >= (int)program.size())
+			{
+				PCcurr = nextPC;
+				break;
+			}
+			TranslatedBlock *&successor = block->next[taken];
+			if (successor == nullptr)
+				successor = lookupBlock(nextPC);
+			else
+				++blockChains;
+			block = successor;
 		}
-		handleExit(SUCCESS, clockCycles);
+		for (auto &p : blockCache)
+		{
+			for (int pc = p.second.start; pc < p.second.end; ++pc)
+				commandCount[pc] += p.second.executions;
+			executed += p.second.executions * (p.second.end - p.second.start);
+			p.second.executions = 0;
+		}
+		if (ret != SUCCESS)
+		{
+			trace->finish(executed + 1, registers, data);
+			handleExit(ret, executed + 1);
+			return executed;
+		}
+		printRegistersAndMemoryDelta(executed);
+		trace->finish(executed, registers, data);
+		handleExit(SUCCESS, executed);
+		return executed;
 	}
 
-	// print the register data in hexadecimal
+	// print the translation cache counters
+	void printBlockCacheStats()
+	{
+		std::cerr << "Blocks translated: " << blockTranslations << '\n';
+		std::cerr << "Block cache hits: " << blockCacheHits << '\n';
+		std::cerr << "Chained block transitions: " << blockChains << '\n';
+	}
+
+	// hand the register data and this cycle's memory delta to the trace sink
 	void printRegistersAndMemoryDelta(int clockCycle)
 	{
-		for (int i = 0; i < 32; ++i)
-			std::cout << registers[i] << ' ';
-		std::cout << '\n';
-		std::cout << memoryDelta.size() << ' ';
-		for (auto &p : memoryDelta)
-			std::cout << p.first << ' ' << p.second << '\n';
-		memoryDelta.clear();
+		trace->cycle(clockCycle, registers, data);
+		data.clearDeltas();
 	}
 };
 
@@ -0,0 +1,162 @@
+/**
+ * @file MIPS_Profile.hpp
+ * @brief Per instruction profile shared by the engines: next to the
+ * executions in commandCount, the cycles every static instruction spent in each
+ * stage, the cycles it was held by each stall cause and its mispredictions,
+ * reported as the hottest instructions and loops, or as CSV.
+ *
+ */
+
+#ifndef __MIPS_PROFILE_HPP__
+#define __MIPS_PROFILE_HPP__
+
+#include <algorithm>
+#include <numeric>
+#include <ostream>
+#include "MIPS_Program.hpp"
+#include "MIPS_CpiStack.hpp"
+
+struct PcProfile
+{
+	// a backward branch or jump and the instructions from its target up to it
+	struct Loop
+	{
+		long long cycles;
+		int start, end;
+	};
+
+	std::vector<std::string> stages;
+	std::vector<long long> stageCycles;						  // by pc, then stage
+	std::vector<std::array<long long, STALL_CAUSES>> stalls; // by pc, cycles held in a stage by each cause
+	std::vector<long long> mispredicts;						  // by pc
+
+	void reset(size_t programSize, const std::vector<std::string> &stageNames)
+	{
+		stages = stageNames;
+		stageCycles.assign(programSize * stages.size(), 0);
+		stalls.assign(programSize, std::array<long long, STALL_CAUSES>());
+		mispredicts.assign(programSize, 0);
+	}
+
+	// the engines without a pipeline spend a cycle per instruction, so their profile is the executions in commandCount
+	void fromExecutions(const MIPS_Program &mips)
+	{
+		reset(mips.program.size(), {"execute"});
+		for (int pc = 0; pc < (int)mips.program.size(); ++pc)
+			occupy(pc, 0, mips.commandCount[pc]);
+	}
+
+	// n cycles the instruction at pc spent in the stage
+	void occupy(int pc, int stage, long long n)
+	{
+		stageCycles[pc * stages.size() + stage] += n;
+	}
+	// the instruction's cycles in every stage, or in the given one
+	long long cycles(int pc, int stage = -1) const
+	{
+		auto first = stageCycles.begin() + pc * stages.size();
+		return stage == -1 ? std::accumulate(first, first + stages.size(), 0ll) : first[stage];
+	}
+	long long stallCycles(int pc) const
+	{
+		return std::accumulate(stalls[pc].begin(), stalls[pc].end(), 0ll);
+	}
+
+	static void printCommand(const MIPS_Program &mips, int pc)
+	{
+		for (auto &s : mips.commands[pc])
+			std::cerr << s << ' ';
+		std::cerr << '\n';
+	}
+
+	/*
+		the instructions that spent the most cycles, hottest first, then the loops: a backward
+		branch or jump and the instructions from its target up to it, with the cycles all of them spent
+	*/
+	void print(const MIPS_Program &mips, int top)
+	{
+		int size = mips.program.size();
+		long long total = 0;
+		std::vector<int> order(size);
+		for (int pc = 0; pc < size; ++pc)
+			order[pc] = pc, total += cycles(pc);
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+						 { return cycles(a) > cycles(b); });
+		double percent = total > 0 ? 100.0 / total : 0;
+		std::cerr << "Hottest instructions, by cycles spent:\n";
+		long long cumulative = 0;
+		for (int i = 0; i < std::min(top, size) && cycles(order[i]) > 0; ++i)
+		{
+			int pc = order[i];
+			cumulative += cycles(pc);
+			std::cerr << cycles(pc) << " cycles (" << cycles(pc) * percent << "%, " << cumulative * percent << "% so far), "
+					  << mips.commandCount[pc] << " executions";
+			auto worst = std::max_element(stalls[pc].begin(), stalls[pc].end());
+			if (*worst > 0)
+				std::cerr << ", " << stallCycles(pc) << " stalled, " << *worst << " by " << CpiStack::NAMES[worst - stalls[pc].begin()];
+			if (mispredicts[pc] > 0)
+				std::cerr << ", " << mispredicts[pc] << " mispredicted";
+			std::cerr << ":\t";
+			printCommand(mips, pc);
+		}
+		// a back edge needs a resolved target, an unknown label leaves it at -1
+		std::vector<Loop> loops;
+		for (int pc = 0; pc < size; ++pc)
+		{
+			const Instruction &ins = mips.program[pc];
+			if ((ins.op == OP_BEQ || ins.op == OP_BNE || ins.op == OP_J) && ins.error == MIPS_Program::SUCCESS && ins.target >= 0 &&
+				ins.target <= pc && mips.commandCount[pc] > 0)
+			{
+				long long sum = 0;
+				for (int body = ins.target; body <= pc; ++body)
+					sum += cycles(body);
+				loops.push_back({sum, ins.target, pc});
+			}
+		}
+		std::stable_sort(loops.begin(), loops.end(), [](const Loop &a, const Loop &b)
+						 { return a.cycles > b.cycles; });
+		std::cerr << "Hottest loops:\n";
+		for (int i = 0; i < std::min(top, (int)loops.size()); ++i)
+		{
+			int start = loops[i].start, end = loops[i].end;
+			std::cerr << loops[i].cycles << " cycles (" << loops[i].cycles * percent << "%), " << end - start + 1
+					  << " instructions, " << mips.commandCount[end] << " iterations:\t";
+			printCommand(mips, start);
+			std::cerr << "\t... ";
+			printCommand(mips, end);
+		}
+	}
+
+	// one row per instruction: executions, mispredictions, cycles in total and per stage, stall cycles per cause
+	void writeCsv(std::ostream &out, const MIPS_Program &mips)
+	{
+		auto column = [](std::string name)
+		{
+			std::replace(name.begin(), name.end(), ' ', '_');
+			return name;
+		};
+		out << "pc,instruction,executions,mispredicts,cycles";
+		for (auto &stage : stages)
+			out << ",cycles_" << stage;
+		for (const char *cause : CpiStack::NAMES)
+			if (cause != CpiStack::NAMES[BASE])
+				out << ",stall_" << column(cause);
+		out << '\n';
+		for (int pc = 0; pc < (int)mips.program.size(); ++pc)
+		{
+			out << pc << ",\"";
+			const char *separator = "";
+			for (auto &s : mips.commands[pc])
+				if (!s.empty())
+					out << separator << s, separator = " ";
+			out << "\"," << mips.commandCount[pc] << ',' << mispredicts[pc] << ',' << cycles(pc);
+			for (int stage = 0; stage < (int)stages.size(); ++stage)
+				out << ',' << cycles(pc, stage);
+			for (int cause = BASE + 1; cause < STALL_CAUSES; ++cause)
+				out << ',' << stalls[pc][cause];
+			out << '\n';
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,524 @@
+/**
+ * @file MIPS_Program.hpp
+ * @brief Program loading shared by every MIPS_Architecture engine: maps the
+ * assembly source, lexes it in place and decodes it once into fixed-size
+ * instruction records, or maps a pre-assembled program image that already holds them.
+ *
+ */
+
+#ifndef __MIPS_PROGRAM_HPP__
+#define __MIPS_PROGRAM_HPP__
+
+#include <unordered_map>
+#include <string>
+#include <string_view>
+#include <array>
+#include <deque>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum Opcode : uint8_t
+{
+	OP_ADD = 0,
+	OP_SUB,
+	OP_MUL,
+	OP_SLT,
+	OP_ADDI,
+	OP_LW,
+	OP_SW,
+	OP_BEQ,
+	OP_BNE,
+	OP_J,
+	OP_INVALID
+};
+
+/*
+	decoded form of one line of commands:
+	r1, r2, r3: operand registers in source order (lw/sw: r1 is the data register, r2 the base)
+	imm: addi immediate or lw/sw offset
+	target: resolved beq/bne/j target PC
+	error: exit code raised when the instruction is executed, 0 if it is valid
+*/
+struct Instruction
+{
+	Opcode op;
+	uint8_t r1, r2, r3;
+	int imm;
+	int target;
+	int error;
+};
+static_assert(sizeof(Instruction) == 16, "Instruction is expected to stay a 16 byte record");
+
+/*
+	pre-assembled program image, all integers little endian:
+	header: "MIPSIMG1", instruction, label and initial data word counts, string pool size
+	instructions: the decoded Instruction records, stored as they are in memory
+	labels: (name offset, name length, PC) per entry of the label table
+	data: (word index, value) per initial data word, always empty as the assembly has no data directives
+	commands: (offset, length) of the four tokens of every command, for printing
+	strings: the pool the label and token offsets point into
+*/
+struct ImageHeader
+{
+	char magic[8];
+	uint32_t instructions, labels, dataWords, stringBytes;
+};
+struct ImageString
+{
+	uint32_t offset, length;
+};
+struct ImageLabel
+{
+	ImageString name;
+	int32_t pc;
+};
+static const char IMAGE_MAGIC[8] = {'M', 'I', 'P', 'S', 'I', 'M', 'G', '1'};
+
+/*
+	perfect hash over a fixed set of names, built at compile time:
+	the FNV-1a seed is searched until every name lands in its own slot,
+	so a lookup is one hash and one comparison. Slots are byte indices into
+	the names, so a sparse table stays small
+*/
+struct NameValue
+{
+	std::string_view name;
+	int value;
+};
+template <size_t N, size_t SLOTS>
+struct PerfectHash
+{
+	static_assert((SLOTS & (SLOTS - 1)) == 0 && N < 255, "slot count must be a power of two");
+	std::array<NameValue, N + 1> names{}; // names[0] is the empty name of unused slots
+	std::array<uint8_t, SLOTS> slots{};
+	uint32_t seed = 0;
+
+	static constexpr uint32_t hash(std::string_view name, uint32_t seed)
+	{
+		uint32_t h = 2166136261u ^ seed;
+		for (char c : name)
+			h = (h ^ (uint8_t)c) * 16777619u;
+		return (h ^ (h >> 15)) & (SLOTS - 1);
+	}
+
+	constexpr PerfectHash(const std::array<NameValue, N> &set)
+	{
+		for (size_t i = 0; i < N; ++i)
+			names[i + 1] = set[i];
+		for (bool placed = false; !placed; ++seed)
+		{
+			slots = {};
+			placed = true;
+			for (size_t i = 1; i <= N && placed; ++i)
+			{
+				uint8_t &slot = slots[hash(names[i].name, seed)];
+				placed = slot == 0;
+				slot = i;
+			}
+		}
+		--seed;
+	}
+
+	// value of the name, missing if it is not in the set
+	constexpr int find(std::string_view name, int missing) const
+	{
+		const NameValue &entry = names[slots[hash(name, seed)]];
+		return !entry.name.empty() && entry.name == name ? entry.value : missing;
+	}
+};
+
+static constexpr PerfectHash<10, 64> MNEMONICS({{{"add", OP_ADD}, {"sub", OP_SUB}, {"mul", OP_MUL}, {"slt", OP_SLT}, {"addi", OP_ADDI}, {"lw", OP_LW}, {"sw", OP_SW}, {"beq", OP_BEQ}, {"bne", OP_BNE}, {"j", OP_J}}});
+static constexpr PerfectHash<64, 512> REGISTERS({{{"$0", 0}, {"$1", 1}, {"$2", 2}, {"$3", 3}, {"$4", 4}, {"$5", 5}, {"$6", 6}, {"$7", 7}, {"$8", 8}, {"$9", 9}, {"$10", 10}, {"$11", 11}, {"$12", 12}, {"$13", 13}, {"$14", 14}, {"$15", 15}, {"$16", 16}, {"$17", 17}, {"$18", 18}, {"$19", 19}, {"$20", 20}, {"$21", 21}, {"$22", 22}, {"$23", 23}, {"$24", 24}, {"$25", 25}, {"$26", 26}, {"$27", 27}, {"$28", 28}, {"$29", 29}, {"$30", 30}, {"$31", 31},
+															  {"$zero", 0}, {"$at", 1}, {"$v0", 2}, {"$v1", 3}, {"$a0", 4}, {"$a1", 5}, {"$a2", 6}, {"$a3", 7}, {"$t0", 8}, {"$t1", 9}, {"$t2", 10}, {"$t3", 11}, {"$t4", 12}, {"$t5", 13}, {"$t6", 14}, {"$t7", 15},
+															  {"$s0", 16}, {"$s1", 17}, {"$s2", 18}, {"$s3", 19}, {"$s4", 20}, {"$s5", 21}, {"$s6", 22}, {"$s7", 23}, {"$t8", 24}, {"$t9", 25}, {"$k0", 26}, {"$k1", 27}, {"$gp", 28}, {"$sp", 29}, {"$s8", 30}, {"$ra", 31}}});
+
+// a read-only mapping of a whole file, unmapped with its owner
+struct MappedFile
+{
+	const char *data = nullptr;
+	size_t size = 0;
+
+	MappedFile() = default;
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+	~MappedFile()
+	{
+		unmap();
+	}
+
+	// returns false if the file could not be opened, an empty file maps to nothing
+	bool map(const char *path)
+	{
+		unmap();
+		int fd = open(path, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		bool opened = fstat(fd, &st) == 0;
+		if (opened && st.st_size > 0)
+		{
+			void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			opened = mapped != MAP_FAILED;
+			if (opened)
+				data = (const char *)mapped, size = st.st_size;
+		}
+		close(fd);
+		return opened;
+	}
+
+	void unmap()
+	{
+		if (data != nullptr)
+			munmap((void *)data, size);
+		data = nullptr, size = 0;
+	}
+
+	std::string_view view() const
+	{
+		return std::string_view(data, size);
+	}
+};
+
+struct MIPS_Program
+{
+	// tokens and labels are views into the mapped source (or image), text holds a source read from a stream
+	MappedFile mapped;
+	std::string text;
+	std::deque<std::string> joined; // the last operand of commands with more than four tokens
+	std::unordered_map<std::string_view, int> address;
+	std::vector<std::array<std::string_view, 4>> commands;
+	std::vector<Instruction> program;
+	std::vector<int> commandCount;
+	enum exit_code
+	{
+		SUCCESS = 0,
+		INVALID_REGISTER,
+		INVALID_LABEL,
+		INVALID_ADDRESS,
+		SYNTAX_ERROR,
+		MEMORY_ERROR
+	};
+
+	// constructor to parse and decode the program
+	MIPS_Program(std::ifstream &file)
+	{
+		text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		file.close();
+		constructCommands(text);
+		decodeCommands();
+		commandCount.assign(commands.size(), 0);
+	}
+
+	// constructor from a path: a program image is used as is, anything else is lexed as assembly in place
+	MIPS_Program(const char *path)
+	{
+		if (mapped.map(path) && !loadImage())
+		{
+			constructCommands(mapped.view());
+			decodeCommands();
+		}
+		commandCount.assign(commands.size(), 0);
+	}
+
+	// returns the opcode of a mnemonic, OP_INVALID if it is not an instruction
+	static Opcode opcodeOf(std::string_view mnemonic)
+	{
+		return (Opcode)MNEMONICS.find(mnemonic, OP_INVALID);
+	}
+
+	// checks if label is valid
+	inline bool checkLabel(std::string_view str)
+	{
+		return str.size() > 0 && isalpha(str[0]) && std::all_of(str.begin() + 1, str.end(), [](char c)
+																{ return (bool)isalnum(c); }) &&
+			   opcodeOf(str) == OP_INVALID;
+	}
+
+	// checks if the register is a valid one
+	inline bool checkRegister(std::string_view r)
+	{
+		return REGISTERS.find(r, -1) != -1;
+	}
+
+	// checks if all of the registers are valid or not
+	bool checkRegisters(std::initializer_list<std::string_view> regs)
+	{
+		return std::all_of(regs.begin(), regs.end(), [&](std::string_view r)
+						   { return checkRegister(r); });
+	}
+
+	// register index, 0 for an invalid register
+	inline uint8_t registerIndex(std::string_view r)
+	{
+		return REGISTERS.find(r, 0);
+	}
+
+	// resolves a label to its PC, -1 if undefined or defined more than once
+	inline int labelTarget(std::string_view label)
+	{
+		auto it = address.find(label);
+		return it == address.end() ? -1 : it->second;
+	}
+
+	// decimal integer with the semantics of stoi: leading whitespace and trailing characters are
+	// ignored, returns false if there are no digits or the value is out of range
+	static bool parseInt(std::string_view str, int &value)
+	{
+		size_t i = 0;
+		while (i < str.size() && isspace((unsigned char)str[i]))
+			++i;
+		bool negative = i < str.size() && str[i] == '-';
+		if (i < str.size() && (str[i] == '-' || str[i] == '+'))
+			++i;
+		long long magnitude = 0;
+		size_t digits = i;
+		for (; i < str.size() && isdigit((unsigned char)str[i]); ++i)
+			if ((magnitude = magnitude * 10 + (str[i] - '0')) > (long long)INT_MAX + 1)
+				return false;
+		if (i == digits || (!negative && magnitude > INT_MAX))
+			return false;
+		value = negative ? -magnitude : magnitude;
+		return true;
+	}
+
+	// decodes an offset(register) or plain address operand, returns the exit code of a malformed operand
+	int decodeLocation(std::string_view location, Instruction &ins)
+	{
+		if (!location.empty() && location.back() == ')')
+		{
+			size_t lparen = location.find('(');
+			if (!parseInt(lparen == 0 ? "0" : location.substr(0, lparen), ins.imm))
+				return SYNTAX_ERROR;
+			std::string_view reg = location.substr(lparen + 1);
+			reg.remove_suffix(1);
+			if (!checkRegister(reg))
+				return INVALID_ADDRESS;
+			ins.r2 = registerIndex(reg);
+			return SUCCESS;
+		}
+		return parseInt(location, ins.imm) ? SUCCESS : SYNTAX_ERROR;
+	}
+
+	// decode a single command, recording the error the unpipelined engine reports on executing it
+	Instruction decodeCommand(const std::array<std::string_view, 4> &command)
+	{
+		Instruction ins = {opcodeOf(command[0]), 0, 0, 0, 0, -1, SUCCESS};
+		switch (ins.op)
+		{
+		case OP_ADD:
+		case OP_SUB:
+		case OP_MUL:
+		case OP_SLT:
+			ins.r1 = registerIndex(command[1]), ins.r2 = registerIndex(command[2]), ins.r3 = registerIndex(command[3]);
+			if (!checkRegisters({command[1], command[2], command[3]}) || ins.r1 == 0)
+				ins.error = INVALID_REGISTER;
+			break;
+		case OP_ADDI:
+			ins.r1 = registerIndex(command[1]), ins.r2 = registerIndex(command[2]);
+			if (!checkRegisters({command[1], command[2]}) || ins.r1 == 0)
+				ins.error = INVALID_REGISTER;
+			else if (!parseInt(command[3], ins.imm))
+				ins.error = SYNTAX_ERROR;
+			break;
+		case OP_LW:
+		case OP_SW:
+			ins.r1 = registerIndex(command[1]);
+			if (!checkRegister(command[1]) || (ins.op == OP_LW && ins.r1 == 0))
+				ins.error = INVALID_REGISTER;
+			else
+				ins.error = decodeLocation(command[2], ins);
+			break;
+		case OP_BEQ:
+		case OP_BNE:
+			ins.r1 = registerIndex(command[1]), ins.r2 = registerIndex(command[2]);
+			ins.target = labelTarget(command[3]);
+			if (!checkLabel(command[3]))
+				ins.error = SYNTAX_ERROR;
+			else if (ins.target == -1)
+				ins.error = INVALID_LABEL;
+			else if (!checkRegisters({command[1], command[2]}))
+				ins.error = INVALID_REGISTER;
+			break;
+		case OP_J:
+			ins.target = labelTarget(command[1]);
+			if (!checkLabel(command[1]))
+				ins.error = SYNTAX_ERROR;
+			else if (ins.target == -1)
+				ins.error = INVALID_LABEL;
+			break;
+		default:
+			ins.error = SYNTAX_ERROR;
+			break;
+		}
+		return ins;
+	}
+
+	// decode every command once the label addresses are known
+	void decodeCommands()
+	{
+		program.clear();
+		program.reserve(commands.size());
+		for (auto &command : commands)
+			program.push_back(decodeCommand(command));
+	}
+
+	// records the PC of a label, a label defined twice resolves to -1
+	void defineLabel(std::string_view label)
+	{
+		auto it = address.emplace(label, commands.size());
+		if (!it.second)
+			it.first->second = -1;
+	}
+
+	// lex one line in place, assuming correctly formatted MIPS instruction (or label)
+	void parseCommand(std::string_view line, std::vector<std::string_view> &command)
+	{
+		// strip until before the comment begins
+		line = line.substr(0, line.find('#'));
+		command.clear();
+		for (size_t i = 0; i < line.size();)
+		{
+			if (line[i] == ',' || line[i] == ' ' || line[i] == '\t')
+			{
+				++i;
+				continue;
+			}
+			size_t end = i;
+			while (end < line.size() && line[end] != ',' && line[end] != ' ' && line[end] != '\t')
+				++end;
+			command.push_back(line.substr(i, end - i));
+			i = end;
+		}
+		// empty line or a comment only line
+		if (command.empty())
+			return;
+		size_t first = 0;
+		if (command.size() == 1)
+		{
+			defineLabel(command[0].back() == ':' ? command[0].substr(0, command[0].size() - 1) : "?");
+			return;
+		}
+		else if (command[0].back() == ':')
+			defineLabel(command[0].substr(0, command[0].size() - 1)), first = 1;
+		else if (command[0].find(':') != std::string_view::npos)
+		{
+			size_t idx = command[0].find(':');
+			defineLabel(command[0].substr(0, idx));
+			command[0] = command[0].substr(idx + 1);
+		}
+		else if (command[1][0] == ':')
+		{
+			defineLabel(command[0]);
+			command[1] = command[1].substr(1);
+			first = command[1].empty() ? 2 : 1;
+		}
+		if (first == command.size())
+			return;
+		std::array<std::string_view, 4> operands;
+		for (size_t i = first; i < command.size() && i < first + 4; ++i)
+			operands[i - first] = command[i];
+		if (command.size() - first > 4)
+		{
+			std::string last(operands[3]);
+			for (size_t i = first + 4; i < command.size(); ++i)
+				(last += ' ') += command[i];
+			operands[3] = joined.emplace_back(std::move(last));
+		}
+		commands.push_back(operands);
+	}
+
+	// construct the commands vector from the source, one line at a time
+	void constructCommands(std::string_view source)
+	{
+		// lines and colons bound the commands and labels, sizing for them up front avoids rehashing
+		commands.reserve(std::count(source.begin(), source.end(), '\n') + 1);
+		address.reserve(std::count(source.begin(), source.end(), ':'));
+		std::vector<std::string_view> command;
+		while (!source.empty())
+		{
+			size_t end = source.find('\n');
+			parseCommand(source.substr(0, end), command);
+			source.remove_prefix(end == std::string_view::npos ? source.size() : end + 1);
+		}
+	}
+
+	// write the decoded program to a pre-assembled image, returns false if the file could not be written
+	bool writeImage(const std::string &path) const
+	{
+		std::string pool;
+		std::unordered_map<std::string_view, uint32_t> pooled;
+		auto intern = [&](std::string_view str)
+		{
+			auto it = pooled.emplace(str, pool.size());
+			if (it.second)
+				pool += str;
+			return ImageString{it.first->second, (uint32_t)str.size()};
+		};
+		std::vector<ImageLabel> labels;
+		for (auto &label : address)
+			labels.push_back({intern(label.first), label.second});
+		std::vector<ImageString> tokens;
+		for (auto &command : commands)
+			for (auto &token : command)
+				tokens.push_back(intern(token));
+
+		ImageHeader header;
+		memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+		header.instructions = program.size(), header.labels = labels.size(), header.dataWords = 0, header.stringBytes = pool.size();
+		std::ofstream out(path, std::ios::binary);
+		out.write((const char *)&header, sizeof(header));
+		out.write((const char *)program.data(), program.size() * sizeof(Instruction));
+		out.write((const char *)labels.data(), labels.size() * sizeof(ImageLabel));
+		out.write((const char *)tokens.data(), tokens.size() * sizeof(ImageString));
+		out.write(pool.data(), pool.size());
+		return (bool)out;
+	}
+
+	// use the mapped file as a pre-assembled image, returns false if it is not a well formed image.
+	// The instructions are copied out, label and command tokens stay views into the mapping
+	bool loadImage()
+	{
+		ImageHeader header;
+		if (mapped.size < sizeof(header))
+			return false;
+		memcpy(&header, mapped.data, sizeof(header));
+		uint64_t size = sizeof(ImageHeader) + (uint64_t)header.instructions * (sizeof(Instruction) + 4 * sizeof(ImageString)) +
+						(uint64_t)header.labels * sizeof(ImageLabel) + header.stringBytes;
+		if (memcmp(header.magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0 || header.dataWords != 0 || size != mapped.size)
+			return false;
+		const char *at = mapped.data + sizeof(ImageHeader);
+		program.resize(header.instructions);
+		memcpy(program.data(), at, header.instructions * sizeof(Instruction));
+		at += header.instructions * sizeof(Instruction);
+		bool valid = true;
+		for (auto &ins : program)
+			valid = valid && ins.op <= OP_INVALID && ins.r1 < 32 && ins.r2 < 32 && ins.r3 < 32 && ins.target >= -1 && ins.target <= (int)header.instructions;
+		const ImageLabel *labels = (const ImageLabel *)at;
+		const ImageString *tokens = (const ImageString *)(at + header.labels * sizeof(ImageLabel));
+		const char *pool = (const char *)(tokens + 4 * (uint64_t)header.instructions);
+		auto text = [&](const ImageString &str)
+		{
+			valid = valid && str.offset + (uint64_t)str.length <= header.stringBytes;
+			return valid ? std::string_view(pool + str.offset, str.length) : std::string_view();
+		};
+		for (uint32_t i = 0; i < header.labels; ++i)
+			address[text(labels[i].name)] = labels[i].pc;
+		commands.resize(header.instructions);
+		for (uint32_t i = 0; i < header.instructions; ++i)
+			commands[i] = {text(tokens[4 * i]), text(tokens[4 * i + 1]), text(tokens[4 * i + 2]), text(tokens[4 * i + 3])};
+		if (!valid)
+			program.clear(), address.clear(), commands.clear();
+		return valid;
+	}
+};
+
+#endif
@@ -0,0 +1,110 @@
+/**
+ * @file MIPS_Timeline.hpp
+ * @brief Per-instruction pipeline timeline in the Kanata log format read by the
+ * Konata pipeline viewer: the cycle every dynamic instruction enters each stage,
+ * the cycles it is held and why, and whether it retires or is squashed.
+ *
+ */
+
+#ifndef __MIPS_TIMELINE_HPP__
+#define __MIPS_TIMELINE_HPP__
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+/*
+	Kanata 0004, one command per line, fields separated by tabs:
+	C=	<cycle>						first cycle of the log
+	C	<cycles>					the cycles that passed since the previous command
+	I	<id>	<sequence>	<thread>	a new instruction, ids are given in fetch order
+	L	<id>	0	<text>			its label, the pc and the disassembly
+	S	<id>	<lane>	<stage>		it enters a stage: lane 0 holds the stages, lane 1 the stall causes
+	E	<id>	<lane>	<stage>		it leaves the stage
+	R	<id>	<retired>	<flushed>	it leaves the pipeline: retired in order, or squashed with 1
+*/
+struct KanataTimeline
+{
+	// the stage and the stall an instruction is in
+	struct InFlight
+	{
+		std::string stage;
+		const char *stall = nullptr;
+	};
+
+	std::ostream &out;
+	std::unordered_map<int, InFlight> inFlight; // by id
+	int current = -1;							// the cycle of the last command, -1 before the first
+	long long retired = 0;
+
+	KanataTimeline(std::ostream &out) : out(out)
+	{
+		out << "Kanata\t0004\n";
+	}
+
+	// the following commands happen in the given cycle
+	void cycle(int clockCycle)
+	{
+		if (current == -1)
+			out << "C=\t" << clockCycle << '\n';
+		else if (clockCycle > current)
+			out << "C\t" << clockCycle - current << '\n';
+		current = clockCycle;
+	}
+
+	void fetch(int id, int thread, int pc, const std::string &text, const std::string &stage)
+	{
+		out << "I\t" << id << '\t' << id << '\t' << thread << '\n';
+		out << "L\t" << id << "\t0\t" << pc << ": " << text << '\n';
+		out << "S\t" << id << "\t0\t" << stage << '\n';
+		inFlight[id].stage = stage;
+	}
+
+	// the instruction moves on to the stage, ending any stall it was held by
+	void stage(int id, const std::string &stage)
+	{
+		InFlight &at = inFlight[id];
+		endStall(id, at);
+		out << "E\t" << id << "\t0\t" << at.stage << '\n';
+		out << "S\t" << id << "\t0\t" << stage << '\n';
+		at.stage = stage;
+	}
+
+	// the instruction stays in its stage for the cause, a run of cycles held by one cause is one stall
+	void stall(int id, const char *cause)
+	{
+		InFlight &at = inFlight[id];
+		if (at.stall == cause)
+			return;
+		endStall(id, at);
+		out << "S\t" << id << "\t1\t" << cause << '\n';
+		at.stall = cause;
+	}
+
+	void retire(int id)
+	{
+		leave(id);
+		out << "R\t" << id << '\t' << retired++ << "\t0\n";
+	}
+	void squash(int id)
+	{
+		leave(id);
+		out << "R\t" << id << "\t0\t1\n";
+	}
+
+	void endStall(int id, InFlight &at)
+	{
+		if (at.stall != nullptr)
+			out << "E\t" << id << "\t1\t" << at.stall << '\n';
+		at.stall = nullptr;
+	}
+	void leave(int id)
+	{
+		InFlight &at = inFlight[id];
+		endStall(id, at);
+		out << "E\t" << id << "\t0\t" << at.stage << '\n';
+		inFlight.erase(id);
+	}
+};
+
+#endif
@@ -0,0 +1,431 @@
+/**
+ * @file MIPS_Trace.hpp
+ * @brief Per-cycle trace output shared by every MIPS_Architecture engine.
+ * Engines hand the register file and the cycle's memory delta to a TraceSink,
+ * which either drops it, writes the course text format or writes compact binary.
+ *
+ */
+
+#ifndef __MIPS_TRACE_HPP__
+#define __MIPS_TRACE_HPP__
+
+#include <ostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include "MIPS_Memory.hpp"
+
+struct TraceSink
+{
+	// called once per simulated cycle, data.deltas holds the words stored during the cycle
+	virtual void cycle(int clockCycle, const int registers[32], const PagedMemory &data) = 0;
+	// called for a run of cycles an engine skipped because nothing changed in them
+	virtual void idle(int firstCycle, int lastCycle, const int registers[32], const PagedMemory &data)
+	{
+		for (int clockCycle = firstCycle; clockCycle <= lastCycle; ++clockCycle)
+			cycle(clockCycle, registers, data);
+	}
+	// called once when the engine stops, before its exit summary
+	virtual void finish(int clockCycles, const int registers[32], const PagedMemory &data) = 0;
+	virtual ~TraceSink() {}
+};
+
+// formats into a large buffer and hands it to the stream in big writes
+struct BufferedTraceSink : TraceSink
+{
+	static const size_t BUFFER_SIZE = 1 << 20;
+	std::ostream &out;
+	std::vector<char> buffer;
+	size_t used = 0;
+	uint64_t written = 0; // bytes already handed to the stream
+
+	BufferedTraceSink(std::ostream &out) : out(out), buffer(BUFFER_SIZE) {}
+	~BufferedTraceSink() { flush(); }
+
+	void flush()
+	{
+		out.write(buffer.data(), used);
+		out.flush();
+		written += used;
+		used = 0;
+	}
+
+	// make room for at least n more bytes
+	inline void reserve(size_t n)
+	{
+		if (used + n > buffer.size())
+			flush();
+	}
+
+	inline void put(char c)
+	{
+		buffer[used++] = c;
+	}
+
+	inline void putBytes(const void *bytes, size_t n)
+	{
+		memcpy(buffer.data() + used, bytes, n);
+		used += n;
+	}
+
+	// decimal text of a signed value
+	inline void putInt(long long value)
+	{
+		char digits[24];
+		int n = 0;
+		unsigned long long magnitude = value < 0 ? 0ull - (unsigned long long)value : value;
+		do
+			digits[n++] = '0' + magnitude % 10;
+		while (magnitude /= 10);
+		if (value < 0)
+			put('-');
+		while (n)
+			put(digits[--n]);
+	}
+};
+
+/*
+	per-cycle output off; only the final registers and the cycle count are printed:
+	<32 registers>
+	Total number of cycles: <cycles>
+*/
+struct NoTraceSink : BufferedTraceSink
+{
+	NoTraceSink(std::ostream &out) : BufferedTraceSink(out) {}
+
+	void cycle(int clockCycle, const int registers[32], const PagedMemory &data) {}
+
+	void idle(int firstCycle, int lastCycle, const int registers[32], const PagedMemory &data) {}
+
+	void finish(int clockCycles, const int registers[32], const PagedMemory &data)
+	{
+		reserve(32 * 13 + 64);
+		for (int i = 0; i < 32; ++i)
+			putInt(registers[i]), put(' ');
+		put('\n');
+		const char *total = "Total number of cycles: ";
+		putBytes(total, strlen(total));
+		putInt(clockCycles);
+		put('\n');
+		flush();
+	}
+};
+
+/*
+	the course text format, one block per cycle:
+	<32 registers>
+	<number of changed words> [<word index> <value>, one per line]
+*/
+struct TextTraceSink : BufferedTraceSink
+{
+	TextTraceSink(std::ostream &out) : BufferedTraceSink(out) {}
+
+	void cycle(int clockCycle, const int registers[32], const PagedMemory &data)
+	{
+		reserve(32 * 13 + 16 + data.deltas.size() * 26);
+		for (int i = 0; i < 32; ++i)
+			putInt(registers[i]), put(' ');
+		put('\n');
+		putInt(data.deltas.size()), put(' ');
+		if (data.deltas.empty())
+			put('\n');
+		for (uint32_t word : data.deltas)
+			putInt(word), put(' '), putInt(data.read(word)), put('\n');
+	}
+
+	void finish(int clockCycles, const int registers[32], const PagedMemory &data)
+	{
+		flush();
+	}
+};
+
+/*
+	compact binary with register deltas only, one record per cycle:
+	uint8 number of changed registers, then (uint8 register, int32 value) for each
+	Values are in host byte order; the file starts with the magic "MIPSREG1".
+*/
+struct BinaryTraceSink : BufferedTraceSink
+{
+	int previous[32] = {0};
+
+	BinaryTraceSink(std::ostream &out) : BufferedTraceSink(out)
+	{
+		putBytes("MIPSREG1", 8);
+	}
+
+	void cycle(int clockCycle, const int registers[32], const PagedMemory &data)
+	{
+		reserve(1 + 32 * 5);
+		size_t countAt = used;
+		uint8_t changed = 0;
+		put(0);
+		for (int i = 0; i < 32; ++i)
+			if (registers[i] != previous[i])
+			{
+				put(i);
+				putBytes(&registers[i], 4);
+				previous[i] = registers[i];
+				++changed;
+			}
+		buffer[countAt] = changed;
+	}
+
+	void finish(int clockCycles, const int registers[32], const PagedMemory &data)
+	{
+		flush();
+	}
+};
+
+/*
+	delta trace: only what changed in each cycle, with periodic keyframes for seeking.
+	All integers are in host byte order.
+
+	header:   "MIPSDTR1", uint32 keyframe interval
+	records, one per cycle, in cycle order:
+	  delta: uint8 changed registers (0 to 32, doubling as the record tag), (uint8 register, int32 value) each,
+	         varint changed words, (uint32 word index, int32 value) each; its cycle follows the previous record's
+	  'K'    uint32 cycle, int32 registers[32], uint32 non-zero words, (uint32 word index, int32 value) each,
+	      uint32 changed words, uint32 word index each
+	  a keyframe replaces the delta record of every interval-th cycle and holds the full state after it
+	footer:   'E', uint32 keyframes, (uint32 record number, uint64 file offset) each,
+	          uint64 offset of the 'E', "MIPSDIDX"
+*/
+struct DeltaTraceSink : BufferedTraceSink
+{
+	static const uint32_t DEFAULT_KEYFRAME_INTERVAL = 4096;
+	uint32_t interval, records = 0;
+	int previous[32] = {0};
+	std::vector<std::pair<uint32_t, uint64_t>> keyframes;
+
+	DeltaTraceSink(std::ostream &out, uint32_t interval = DEFAULT_KEYFRAME_INTERVAL) : BufferedTraceSink(out), interval(interval)
+	{
+		putBytes("MIPSDTR1", 8);
+		putBytes(&interval, 4);
+	}
+
+	// bytes may not fit the buffer in one go for keyframes of large memories
+	void putLarge(const void *bytes, size_t n)
+	{
+		const char *p = (const char *)bytes;
+		while (n)
+		{
+			reserve(1);
+			size_t chunk = std::min(n, buffer.size() - used);
+			putBytes(p, chunk);
+			p += chunk, n -= chunk;
+		}
+	}
+
+	uint64_t offset() const
+	{
+		return written + used;
+	}
+
+	void cycle(int clockCycle, const int registers[32], const PagedMemory &data)
+	{
+		uint32_t cycleNumber = clockCycle, changedWords = data.deltas.size();
+		if (records++ % interval == 0)
+		{
+			reserve(256);
+			keyframes.emplace_back(records - 1, offset());
+			put('K');
+			putBytes(&cycleNumber, 4);
+			putBytes(registers, 32 * 4);
+			memcpy(previous, registers, sizeof(previous));
+			std::vector<std::pair<uint32_t, int>> words;
+			data.forEachNonZero([&](uint32_t word, int value)
+								{ words.emplace_back(word, value); });
+			uint32_t count = words.size();
+			putBytes(&count, 4);
+			putLarge(words.data(), words.size() * 8);
+			reserve(4);
+			putBytes(&changedWords, 4);
+			putLarge(data.deltas.data(), changedWords * 4);
+			return;
+		}
+		reserve(8 + 32 * 5);
+		size_t countAt = used;
+		uint8_t changed = 0;
+		put(0);
+		for (int i = 0; i < 32; ++i)
+			if (registers[i] != previous[i])
+			{
+				put(i);
+				putBytes(&registers[i], 4);
+				previous[i] = registers[i];
+				++changed;
+			}
+		buffer[countAt] = changed;
+		// LEB128: seven bits per byte, high bit set while more bytes follow
+		do
+			put((changedWords & 127) | (changedWords > 127 ? 128 : 0));
+		while (changedWords >>= 7);
+		for (uint32_t word : data.deltas)
+		{
+			int value = data.read(word);
+			reserve(8);
+			putBytes(&word, 4);
+			putBytes(&value, 4);
+		}
+	}
+
+	void finish(int clockCycles, const int registers[32], const PagedMemory &data)
+	{
+		uint64_t indexAt = offset();
+		uint32_t count = keyframes.size();
+		reserve(5);
+		put('E');
+		putBytes(&count, 4);
+		for (auto &k : keyframes)
+		{
+			reserve(12);
+			putBytes(&k.first, 4);
+			putBytes(&k.second, 8);
+		}
+		reserve(16);
+		putBytes(&indexAt, 8);
+		putBytes("MIPSDIDX", 8);
+		flush();
+	}
+};
+
+/*
+	streams a delta trace back, keeping the machine state after the last record read.
+	Random access seeks to the closest keyframe before the wanted record and replays from there.
+*/
+struct DeltaTraceReader
+{
+	FILE *file = nullptr;
+	uint32_t interval = 0, record = 0; // number of records read so far
+	uint32_t cycle = 0;				   // cycle number of the last record
+	int registers[32] = {0};
+	PagedMemory data;
+	std::vector<std::pair<uint32_t, uint64_t>> keyframes;
+
+	~DeltaTraceReader()
+	{
+		if (file != nullptr)
+			fclose(file);
+	}
+
+	// open the trace and read its keyframe index, false if it is not a delta trace
+	bool open(const std::string &path)
+	{
+		file = fopen(path.c_str(), "rb");
+		char magic[8];
+		if (file == nullptr || fread(magic, 1, 8, file) != 8 || memcmp(magic, "MIPSDTR1", 8) != 0 || fread(&interval, 4, 1, file) != 1)
+			return false;
+		uint64_t indexAt;
+		uint32_t count;
+		if (fseek(file, -16, SEEK_END) != 0 || fread(&indexAt, 8, 1, file) != 1 || fread(magic, 1, 8, file) != 8 || memcmp(magic, "MIPSDIDX", 8) != 0)
+			return false;
+		if (fseek(file, indexAt + 1, SEEK_SET) != 0 || fread(&count, 4, 1, file) != 1)
+			return false;
+		keyframes.resize(count);
+		for (auto &k : keyframes)
+			if (fread(&k.first, 4, 1, file) != 1 || fread(&k.second, 8, 1, file) != 1)
+				return false;
+		return fseek(file, 12, SEEK_SET) == 0;
+	}
+
+	template <typename T>
+	bool get(T &value)
+	{
+		return fread(&value, sizeof(T), 1, file) == 1;
+	}
+
+	/*
+		read the next record, applying it to registers and data. data.deltas is left
+		holding the words that changed in that cycle; false at the end of the trace
+	*/
+	bool next()
+	{
+		uint8_t tag;
+		uint32_t count, word;
+		int value;
+		if (!get(tag) || (tag > 32 && tag != 'K'))
+			return false;
+		data.clearDeltas();
+		if (tag == 'K')
+		{
+			if (!get(cycle))
+				return false;
+			if (fread(registers, 4, 32, file) != 32 || !get(count))
+				return false;
+			data = PagedMemory();
+			for (uint32_t i = 0; i < count; ++i)
+				if (!get(word) || !get(value))
+					return false;
+				else
+					data.write(word, value);
+			if (!get(count))
+				return false;
+			for (uint32_t i = 0; i < count; ++i)
+				if (!get(word))
+					return false;
+				else
+					data.deltas.push_back(word);
+		}
+		else
+		{
+			uint8_t reg, byte;
+			++cycle;
+			for (int i = 0; i < tag; ++i)
+				if (!get(reg) || !get(value) || reg >= 32)
+					return false;
+				else
+					registers[reg] = value;
+			count = 0;
+			for (int shift = 0; shift < 35; shift += 7)
+				if (!get(byte))
+					return false;
+				else if (count |= uint32_t(byte & 127) << shift, !(byte & 128))
+					break;
+			for (uint32_t i = 0; i < count; ++i)
+				if (!get(word) || !get(value))
+					return false;
+				else
+					data.writeDelta(word, value);
+		}
+		++record;
+		return true;
+	}
+
+	// position on the state after record number target (counting from 0), false if the trace is shorter
+	bool seek(uint32_t target)
+	{
+		auto k = std::upper_bound(keyframes.begin(), keyframes.end(), std::make_pair(target, ~(uint64_t)0));
+		if (k == keyframes.begin())
+			return false;
+		--k;
+		if (record == 0 || record - 1 > target || record - 1 < k->first)
+		{
+			if (fseek(file, k->second, SEEK_SET) != 0)
+				return false;
+			record = k->first;
+		}
+		while (record <= target)
+			if (!next())
+				return false;
+		return true;
+	}
+};
+
+// sink for a --trace option value: none, text, binary or delta; nullptr if the kind is unknown
+inline TraceSink *makeTraceSink(const std::string &kind, std::ostream &out)
+{
+	if (kind == "none")
+		return new NoTraceSink(out);
+	if (kind == "text")
+		return new TextTraceSink(out);
+	if (kind == "binary")
+		return new BinaryTraceSink(out);
+	if (kind == "delta")
+		return new DeltaTraceSink(out);
+	return nullptr;
+}
+
+#endif
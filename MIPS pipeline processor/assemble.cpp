@@ -0,0 +1,25 @@
+#include "MIPS_Program.hpp"
+#include <iostream>
+
+// assembles a source file once into a program image the engines load without parsing
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		std::cerr << "Required arguments: source and image file names\n./assemble <source file> <image file>\n";
+		return 1;
+	}
+	std::ifstream file(argv[1]);
+	if (!file.is_open())
+	{
+		std::cerr << "File could not be opened. Terminating...\n";
+		return 1;
+	}
+	MIPS_Program program(file);
+	if (!program.writeImage(argv[2]))
+	{
+		std::cerr << "Image could not be written. Terminating...\n";
+		return 1;
+	}
+	return 0;
+}
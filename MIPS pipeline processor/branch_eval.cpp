@@ -0,0 +1,283 @@
+#include "BranchPredictor.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+	Branch traces hold one record per executed conditional branch, in execution order:
+	text	a "<pc> <taken>" line per branch, the pc in hex with or without 0x and taken 0 or 1;
+			blank lines and lines starting with # are skipped
+	binary	"MIPSBTR1", then 8 byte records: the pc and the outcome as 32-bit words in host byte order
+*/
+struct BranchRecord
+{
+	uint32_t pc, taken;
+};
+
+static const char BINARY_MAGIC[8] = {'M', 'I', 'P', 'S', 'B', 'T', 'R', '1'};
+
+// binary traces are mapped and walked in windows, each released once read, so only a window stays resident
+template <typename Visit>
+bool forEachBinaryRecord(int fd, size_t size, Visit visit)
+{
+	const size_t WINDOW = 64 << 20;
+	if ((size - sizeof(BINARY_MAGIC)) % sizeof(BranchRecord) != 0)
+	{
+		std::cerr << "The binary trace ends in a partial record\n";
+		return false;
+	}
+	void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED)
+		return false;
+	madvise(mapped, size, MADV_SEQUENTIAL);
+	const char *base = (const char *)mapped;
+	size_t released = 0;
+	for (size_t at = sizeof(BINARY_MAGIC); at < size; at += sizeof(BranchRecord))
+	{
+		const BranchRecord &record = *(const BranchRecord *)(base + at);
+		visit(record.pc, record.taken != 0);
+		if (at - released >= WINDOW)
+		{
+			madvise((void *)(base + released), WINDOW, MADV_DONTNEED);
+			released += WINDOW;
+		}
+	}
+	munmap(mapped, size);
+	return true;
+}
+
+template <typename Visit>
+bool forEachTextRecord(FILE *file, Visit visit)
+{
+	char *line = nullptr;
+	size_t capacity = 0;
+	long long number = 0;
+	bool ok = true;
+	while (getline(&line, &capacity, file) != -1)
+	{
+		++number;
+		char *at = line;
+		while (isspace((unsigned char)*at))
+			++at;
+		if (*at == '\0' || *at == '#')
+			continue;
+		char *end;
+		uint32_t pc = strtoul(at, &end, 16);
+		char *outcome = end;
+		long taken = strtol(outcome, &end, 10);
+		if (end == outcome || (taken != 0 && taken != 1))
+		{
+			std::cerr << "Line " << number << " is not a branch record\n";
+			ok = false;
+			break;
+		}
+		visit(pc, taken == 1);
+	}
+	free(line);
+	return ok;
+}
+
+// calls visit(pc, taken) for every record of the trace, text or binary; false if it cannot be read
+template <typename Visit>
+bool forEachBranch(const char *path, Visit visit)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr)
+		return false;
+	char magic[sizeof(BINARY_MAGIC)];
+	bool binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+	bool ok;
+	if (binary)
+	{
+		struct stat info;
+		ok = fstat(fileno(file), &info) == 0 && forEachBinaryRecord(fileno(file), info.st_size, visit);
+	}
+	else
+		ok = fseek(file, 0, SEEK_SET) == 0 && forEachTextRecord(file, visit);
+	fclose(file);
+	return ok;
+}
+
+// a predictor kind started in one state, and how often it was wrong
+struct Evaluation
+{
+	std::string name;
+	std::unique_ptr<BranchPredictor> predictor;
+	long long mispredicts = 0;
+};
+
+struct EvalOptions
+{
+	std::string predictors = "saturating,bhr,saturating-bhr", states = "00,01,10,11", convertFile;
+	long long instructions = 0; // executed instructions, for MPKI; 0 if unknown
+	int branches = 10;			// static branches in the breakdown, 0 for all
+};
+
+// a state given as two bits (00 to 11) or as a number (0 to 3), -1 if it is neither
+int parseState(const std::string &state)
+{
+	if (state.size() == 2 && (state[0] == '0' || state[0] == '1') && (state[1] == '0' || state[1] == '1'))
+		return (state[0] - '0') << 1 | (state[1] - '0');
+	if (state.size() == 1 && state[0] >= '0' && state[0] <= '3')
+		return state[0] - '0';
+	return -1;
+}
+
+// every listed predictor in every listed state, in one pass; false if a name or state is unknown
+bool makeEvaluations(const EvalOptions &options, std::vector<Evaluation> &evaluations)
+{
+	static const char *STATE_NAMES[4] = {"00", "01", "10", "11"};
+	std::stringstream kinds(options.predictors);
+	std::string kind;
+	while (std::getline(kinds, kind, ','))
+	{
+		std::stringstream states(options.states);
+		std::string state;
+		while (std::getline(states, state, ','))
+		{
+			int value = parseState(state);
+			BranchPredictor *predictor = value == -1 ? nullptr : makePredictor(kind, value);
+			if (predictor == nullptr)
+				return false;
+			evaluations.push_back(Evaluation());
+			evaluations.back().name = kind + ' ' + STATE_NAMES[value];
+			evaluations.back().predictor.reset(predictor);
+		}
+	}
+	return !evaluations.empty();
+}
+
+// writes the records of any trace as a binary trace
+int convert(const char *path, const std::string &outFile)
+{
+	std::ofstream out(outFile, std::ios::binary);
+	if (!out.is_open())
+	{
+		std::cerr << "Output file could not be opened. Terminating...\n";
+		return 0;
+	}
+	out.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+	long long count = 0;
+	if (!forEachBranch(path, [&](uint32_t pc, bool taken)
+					   { BranchRecord record = {pc, taken};
+						 out.write((const char *)&record, sizeof(record));
+						 ++count; }))
+	{
+		std::cerr << "Trace could not be read. Terminating...\n";
+		return 0;
+	}
+	std::cout << count << " branches written to " << outFile << '\n';
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	EvalOptions options;
+	bool valid = argc >= 2;
+	for (int i = 2; i < argc && valid; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument.rfind("--predictors=", 0) == 0)
+			options.predictors = argument.substr(13);
+		else if (argument.rfind("--states=", 0) == 0)
+			options.states = argument.substr(9);
+		else if (argument.rfind("--instructions=", 0) == 0)
+			options.instructions = atoll(argument.c_str() + 15);
+		else if (argument.rfind("--branches=", 0) == 0)
+			options.branches = atoi(argument.c_str() + 11);
+		else if (argument.rfind("--convert=", 0) == 0)
+			options.convertFile = argument.substr(10);
+		else
+			valid = false;
+	}
+	std::vector<Evaluation> evaluations;
+	if (valid && options.convertFile.empty() && !makeEvaluations(options, evaluations))
+	{
+		std::cerr << "Unknown predictor or state in " << options.predictors << " / " << options.states << '\n';
+		valid = false;
+	}
+	if (!valid)
+	{
+		std::cerr << "Required argument: trace_file\n./branch_eval <trace file> [--predictors=saturating,bhr,saturating-bhr] [--states=00,01,10,11] [--instructions=<count>] [--branches=<count>] [--convert=<binary trace file>]\n";
+		return 0;
+	}
+	if (!options.convertFile.empty())
+		return convert(argv[1], options.convertFile);
+
+	// per static branch: executions, taken count and the mispredictions of every evaluation
+	size_t count = evaluations.size();
+	std::unordered_map<uint32_t, int> index;
+	std::vector<uint32_t> pcs;
+	std::vector<long long> executions, takenCount, mispredicts;
+	long long total = 0, totalTaken = 0;
+	uint32_t lastPc = 0;
+	int branch = -1; // the index of lastPc, consecutive records of the same branch skip the lookup
+	bool read = forEachBranch(argv[1], [&](uint32_t pc, bool taken)
+							  {
+		if (branch == -1 || pc != lastPc)
+		{
+			auto found = index.emplace(pc, pcs.size());
+			if (found.second)
+			{
+				pcs.push_back(pc);
+				executions.push_back(0);
+				takenCount.push_back(0);
+				mispredicts.resize(mispredicts.size() + count, 0);
+			}
+			branch = found.first->second;
+			lastPc = pc;
+		}
+		++total, ++executions[branch];
+		totalTaken += taken, takenCount[branch] += taken;
+		long long *wrong = &mispredicts[branch * count];
+		for (size_t i = 0; i < count; ++i)
+		{
+			bool missed = evaluations[i].predictor->predict(pc) != taken;
+			evaluations[i].mispredicts += missed, wrong[i] += missed;
+			evaluations[i].predictor->update(pc, taken);
+		} });
+	if (!read)
+	{
+		std::cerr << "Trace could not be read. Terminating...\n";
+		return 0;
+	}
+
+	auto percent = [](long long part, long long whole)
+	{ return whole > 0 ? 100.0 * part / whole : 0.0; };
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << total << " branches, " << pcs.size() << " static, " << percent(totalTaken, total) << "% taken\n";
+	// without an instruction count the rate is per thousand branches
+	long long per = options.instructions > 0 ? options.instructions : total;
+	std::cout << "predictor\taccuracy\tmispredictions\t" << (options.instructions > 0 ? "MPKI" : "per 1000 branches") << '\n';
+	for (auto &evaluation : evaluations)
+		std::cout << evaluation.name << '\t' << percent(total - evaluation.mispredicts, total) << "%\t"
+				  << evaluation.mispredicts << '\t' << (per > 0 ? 1000.0 * evaluation.mispredicts / per : 0.0) << '\n';
+
+	// the static branches with the most mispredictions over all evaluations first
+	std::vector<long long> missed(pcs.size(), 0);
+	std::vector<int> order(pcs.size());
+	for (size_t b = 0; b < pcs.size(); ++b)
+	{
+		order[b] = b;
+		for (size_t i = 0; i < count; ++i)
+			missed[b] += mispredicts[b * count + i];
+	}
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+					 { return missed[a] > missed[b]; });
+	int shown = options.branches > 0 ? std::min<int>(options.branches, pcs.size()) : pcs.size();
+	std::cout << "Accuracy by branch, most mispredicted first:\npc\texecutions\ttaken";
+	for (auto &evaluation : evaluations)
+		std::cout << '\t' << evaluation.name;
+	std::cout << '\n';
+	for (int i = 0; i < shown; ++i)
+	{
+		int b = order[i];
+		std::cout << std::hex << "0x" << std::setw(8) << std::setfill('0') << pcs[b] << std::dec << std::setfill(' ')
+				  << '\t' << executions[b] << '\t' << percent(takenCount[b], executions[b]) << '%';
+		for (size_t e = 0; e < count; ++e)
+			std::cout << '\t' << percent(executions[b] - mispredicts[b * count + e], executions[b]) << '%';
+		std::cout << '\n';
+	}
+	return 0;
+}
@@ -0,0 +1,245 @@
+#include "MIPS_Pipeline.hpp"
+#include "MIPS_OutOfOrder.hpp"
+#include <sstream>
+
+struct PipelineOptions
+{
+	std::string traceKind = "text", traceFile, timelineFile, profileFile;
+	std::string predictor, fetchPolicy = "round-robin";
+	int memoryLatency = 1, predictorState = 0, btbEntries = 0, storeBuffer = 0, threads = 1;
+	int profileTop = 0; // hottest instructions and loops to report, 0 for no report
+	bool skipIdleCycles = true, resolveInID = false, cpiStack = false;
+	int latency[OP_INVALID] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+	int interval[OP_INVALID] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+	bool unpipelined[OP_INVALID] = {false};
+	OutOfOrderConfig outOfOrder;
+};
+
+// the opcodes of a comma separated list of mnemonics, each passed to set; false if one is not an instruction
+template <typename Setter>
+bool forEachOpcode(const std::string &list, Setter set)
+{
+	std::stringstream entries(list);
+	std::string entry;
+	while (std::getline(entries, entry, ','))
+	{
+		std::string mnemonic = entry.substr(0, entry.find(':'));
+		Opcode op = MIPS_Program::opcodeOf(mnemonic);
+		if (op == OP_INVALID || !set(op, entry.substr(mnemonic.size())))
+			return false;
+	}
+	return true;
+}
+
+// the trace sink the options ask for, writing to stdout or to traceOut; nullptr if it cannot be made
+TraceSink *openTrace(const PipelineOptions &options, std::ofstream &traceOut)
+{
+	if (!options.traceFile.empty())
+		traceOut.open(options.traceFile, std::ios::binary);
+	TraceSink *trace = makeTraceSink(options.traceKind, options.traceFile.empty() ? std::cout : traceOut);
+	if (trace == nullptr || (!options.traceFile.empty() && !traceOut.is_open()))
+	{
+		delete trace;
+		std::cerr << "Invalid trace option. Terminating...\n";
+		return nullptr;
+	}
+	return trace;
+}
+
+// report the profile of an engine and write it as CSV, as the options ask
+template <class Engine>
+void reportProfile(Engine *mips, const PipelineOptions &options)
+{
+	if (options.profileTop > 0)
+		mips->profile.print(*mips, options.profileTop);
+	if (options.profileFile.empty())
+		return;
+	std::ofstream csv(options.profileFile);
+	if (csv.is_open())
+		mips->profile.writeCsv(csv, *mips);
+	else
+		std::cerr << "Profile file could not be opened\n";
+}
+
+// run the program on the pipeline with the given configuration
+template <class Config>
+int runPipeline(const char *path, const PipelineOptions &options)
+{
+	MIPS_Pipeline<Config> *mips = new MIPS_Pipeline<Config>(path);
+	std::ofstream traceOut;
+	TraceSink *trace = openTrace(options, traceOut);
+	if (trace == nullptr)
+		return 0;
+	mips->trace.reset(trace);
+	mips->memoryLatency = options.memoryLatency;
+	for (int op = 0; op < OP_INVALID; ++op)
+	{
+		mips->latency[op] = options.latency[op];
+		mips->interval[op] = options.unpipelined[op] ? options.latency[op] : options.interval[op];
+	}
+	mips->storeBufferSize = options.storeBuffer;
+	mips->threads.resize(options.threads);
+	mips->fetchPolicy = options.fetchPolicy == "fewest-in-flight" ? MIPS_Pipeline<Config>::FEWEST_IN_FLIGHT : MIPS_Pipeline<Config>::ROUND_ROBIN;
+	mips->skipIdleCycles = options.skipIdleCycles;
+	mips->predictor.reset(makePredictor(options.predictor, options.predictorState));
+	if (options.btbEntries > 0)
+		mips->btb.reset(new BranchTargetBuffer(options.btbEntries));
+	mips->resolveBranchesInID = options.resolveInID;
+	mips->stallAccounting = options.cpiStack;
+	mips->profiling = options.profileTop > 0 || !options.profileFile.empty();
+	std::ofstream timelineOut;
+	if (!options.timelineFile.empty())
+	{
+		timelineOut.open(options.timelineFile);
+		if (!timelineOut.is_open())
+		{
+			std::cerr << "Timeline file could not be opened. Terminating...\n";
+			return 0;
+		}
+		mips->timeline.reset(new KanataTimeline(timelineOut));
+	}
+	mips->executeCommandsPipelined();
+	if (mips->predictor || mips->btb || mips->resolveBranchesInID)
+		mips->printBranchStats();
+	if (Config::ISSUE_WIDTH > 1)
+		mips->printIssueStats();
+	if (mips->storeBufferSize > 0)
+		mips->printMemoryStats();
+	if (mips->threads.size() > 1)
+		mips->printThreadStats();
+	if (mips->stallAccounting)
+		mips->printStallStats();
+	if (mips->profiling)
+		reportProfile(mips, options);
+	mips->trace.reset();
+	return 0;
+}
+
+// run the program on the out-of-order engine
+int runOutOfOrder(const char *path, const PipelineOptions &options)
+{
+	MIPS_OutOfOrder *mips = new MIPS_OutOfOrder(path);
+	std::ofstream traceOut;
+	TraceSink *trace = openTrace(options, traceOut);
+	if (trace == nullptr)
+		return 0;
+	mips->trace.reset(trace);
+	mips->config = options.outOfOrder;
+	mips->config.latency[MEMORY_UNIT] = options.memoryLatency;
+	mips->predictor.reset(makePredictor(options.predictor, options.predictorState));
+	mips->stallAccounting = options.cpiStack;
+	mips->profiling = options.profileTop > 0 || !options.profileFile.empty();
+	mips->executeCommandsOutOfOrder();
+	mips->printStats();
+	if (mips->stallAccounting)
+		mips->cpiStack.print(mips->commands);
+	if (mips->profiling)
+		reportProfile(mips, options);
+	mips->trace.reset();
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	std::string pipeline = "--5stage";
+	PipelineOptions options;
+	bool validArguments = argc >= 2;
+	for (int i = 2; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument == "--5stage" || argument == "--5stage-bypass" || argument == "--79stage" || argument == "--79stage-bypass" || argument == "--5stage-bypass-dual" || argument == "--out-of-order")
+			pipeline = argument;
+		else if (argument.rfind("--rob=", 0) == 0)
+			options.outOfOrder.robSize = std::max(1, atoi(argument.c_str() + 6));
+		else if (argument.rfind("--width=", 0) == 0)
+			options.outOfOrder.width = std::max(1, atoi(argument.c_str() + 8));
+		else if (argument.rfind("--stations=", 0) == 0)
+			options.outOfOrder.stations = std::max(1, atoi(argument.c_str() + 11));
+		else if (argument.rfind("--lsq=", 0) == 0)
+			options.outOfOrder.lsqSize = std::max(1, atoi(argument.c_str() + 6));
+		else if (argument.rfind("--units=", 0) == 0)
+		{
+			int *units = options.outOfOrder.units;
+			validArguments &= sscanf(argument.c_str() + 8, "%d,%d,%d", &units[ALU_UNIT], &units[MUL_UNIT], &units[MEMORY_UNIT]) == 3 &&
+							  std::min({units[ALU_UNIT], units[MUL_UNIT], units[MEMORY_UNIT]}) > 0;
+		}
+		else if (argument.rfind("--latency=", 0) == 0)
+		{
+			int *latency = options.outOfOrder.latency;
+			validArguments &= sscanf(argument.c_str() + 10, "%d,%d", &latency[ALU_UNIT], &latency[MUL_UNIT]) == 2 &&
+							  std::min(latency[ALU_UNIT], latency[MUL_UNIT]) > 0;
+		}
+		else if (argument.rfind("--memory-latency=", 0) == 0)
+			options.memoryLatency = std::max(1, atoi(argument.c_str() + 17));
+		else if (argument.rfind("--op-latency=", 0) == 0)
+			validArguments &= forEachOpcode(argument.substr(13), [&](Opcode op, const std::string &cycles)
+											{ int fields = sscanf(cycles.c_str(), ":%d:%d", &options.latency[op], &options.interval[op]);
+											  return fields >= 1 && options.latency[op] > 0 && options.interval[op] > 0; });
+		else if (argument.rfind("--unpipelined=", 0) == 0)
+			validArguments &= forEachOpcode(argument.substr(14), [&](Opcode op, const std::string &rest)
+											{ options.unpipelined[op] = true;
+											  return rest.empty(); });
+		else if (argument.rfind("--store-buffer=", 0) == 0)
+			options.storeBuffer = std::max(0, atoi(argument.c_str() + 15));
+		else if (argument.rfind("--threads=", 0) == 0)
+			options.threads = std::max(1, atoi(argument.c_str() + 10));
+		else if (argument.rfind("--fetch-policy=", 0) == 0)
+		{
+			options.fetchPolicy = argument.substr(15);
+			validArguments &= options.fetchPolicy == "round-robin" || options.fetchPolicy == "fewest-in-flight";
+		}
+		else if (argument.rfind("--predictor=", 0) == 0)
+			options.predictor = argument.substr(12);
+		else if (argument.rfind("--predictor-state=", 0) == 0)
+			options.predictorState = atoi(argument.c_str() + 18) & 3;
+		else if (argument.rfind("--btb=", 0) == 0)
+			options.btbEntries = std::max(0, atoi(argument.c_str() + 6));
+		else if (argument == "--resolve-in-id")
+			options.resolveInID = true;
+		else if (argument == "--cpi-stack")
+			options.cpiStack = true;
+		else if (argument == "--profile")
+			options.profileTop = 10;
+		else if (argument.rfind("--profile=", 0) == 0)
+			options.profileTop = std::max(1, atoi(argument.c_str() + 10));
+		else if (argument.rfind("--profile-csv=", 0) == 0)
+			options.profileFile = argument.substr(14);
+		else if (argument == "--no-skip")
+			options.skipIdleCycles = false;
+		else if (argument.rfind("--trace=", 0) == 0)
+			options.traceKind = argument.substr(8);
+		else if (argument.rfind("--timeline=", 0) == 0)
+			options.timelineFile = argument.substr(11);
+		else if (argument.rfind("--trace-file=", 0) == 0)
+			options.traceFile = argument.substr(13);
+		else
+			validArguments = false;
+	}
+	if (!options.predictor.empty() && std::unique_ptr<BranchPredictor>(makePredictor(options.predictor, 0)) == nullptr)
+		validArguments = false;
+	if (!validArguments)
+	{
+		std::cerr << "Required argument: file_name\n./pipeline <file name or program image> [--5stage | --5stage-bypass | --79stage | --79stage-bypass | --5stage-bypass-dual | --out-of-order] [--memory-latency=<cycles>] [--op-latency=<op>:<cycles>[:<interval>],...] [--unpipelined=<op>,...] [--store-buffer=<entries>] [--threads=<count>] [--fetch-policy=round-robin|fewest-in-flight] [--predictor=saturating|bhr|saturating-bhr] [--predictor-state=<0-3>] [--btb=<entries>] [--resolve-in-id] [--cpi-stack] [--profile[=<count>]] [--profile-csv=<file name>] [--no-skip] [--trace=none|text|binary|delta] [--trace-file=<file name>] [--timeline=<file name>]\n"
+				  << "--out-of-order also takes [--rob=<entries>] [--width=<instructions>] [--stations=<entries>] [--lsq=<entries>] [--units=<alu>,<mul>,<memory>] [--latency=<alu>,<mul>]\n";
+		return 0;
+	}
+	std::ifstream file(argv[1]);
+	if (!file.is_open())
+	{
+		std::cerr << "File could not be opened. Terminating...\n";
+		return 0;
+	}
+	file.close();
+
+	if (pipeline == "--out-of-order")
+		return runOutOfOrder(argv[1], options);
+	if (pipeline == "--5stage-bypass")
+		return runPipeline<Pipeline5Bypass>(argv[1], options);
+	if (pipeline == "--5stage-bypass-dual")
+		return runPipeline<Pipeline5BypassDual>(argv[1], options);
+	if (pipeline == "--79stage")
+		return runPipeline<Pipeline79>(argv[1], options);
+	if (pipeline == "--79stage-bypass")
+		return runPipeline<Pipeline79Bypass>(argv[1], options);
+	return runPipeline<Pipeline5>(argv[1], options);
+}
@@ -1,22 +1,102 @@
 #include "MIPS_Processor.hpp"
+#include "MIPS_Profile.hpp"
+#include <chrono>
+
+// host seconds taken by a fast run
+double timeFastRun(MIPS_Architecture *mips)
+{
+	auto start = std::chrono::steady_clock::now();
+	mips->executeCommandsFast();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
 
 int main(int argc, char *argv[])
 {
-	if (argc != 2)
+	std::string mode, traceKind = "text", traceFile, profileFile;
+	int profileTop = 0; // hottest instructions and loops to report, 0 for no report
+	bool validArguments = argc >= 2;
+	for (int i = 2; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument == "--fast" || argument == "--blocks" || argument == "--fusion-report")
+			mode = argument;
+		else if (argument == "--profile")
+			profileTop = 10;
+		else if (argument.rfind("--profile=", 0) == 0)
+			profileTop = std::max(1, atoi(argument.c_str() + 10));
+		else if (argument.rfind("--profile-csv=", 0) == 0)
+			profileFile = argument.substr(14);
+		else if (argument.rfind("--trace=", 0) == 0)
+			traceKind = argument.substr(8);
+		else if (argument.rfind("--trace-file=", 0) == 0)
+			traceFile = argument.substr(13);
+		else
+			validArguments = false;
+	}
+	if (!validArguments)
 	{
-		std::cerr << "Required argument: file_name\n./MIPS_interpreter <file name>\n";
+		std::cerr << "Required argument: file_name\n./MIPS_interpreter <file name or program image> [--fast | --blocks | --fusion-report] [--profile[=<count>]] [--profile-csv=<file name>] [--trace=none|text|binary] [--trace-file=<file name>]\n";
 		return 0;
 	}
 	std::ifstream file(argv[1]);
 	MIPS_Architecture *mips;
 	if (file.is_open())
-		mips = new MIPS_Architecture(file);
+		file.close(), mips = new MIPS_Architecture(argv[1]);
 	else
 	{
 		std::cerr << "File could not be opened. Terminating...\n";
 		return 0;
 	}
 
-	mips->executeCommandsUnpipelined();
+	std::ofstream traceOut;
+	if (!traceFile.empty())
+		traceOut.open(traceFile, std::ios::binary);
+	TraceSink *trace = makeTraceSink(traceKind, traceFile.empty() ? std::cout : traceOut);
+	if (trace == nullptr || (!traceFile.empty() && !traceOut.is_open()))
+	{
+		std::cerr << "Invalid trace option. Terminating...\n";
+		return 0;
+	}
+	mips->trace.reset(trace);
+
+	if (mode == "--fast")
+		mips->executeCommandsFast();
+	else if (mode == "--blocks")
+	{
+		mips->executeCommandsBlockCached();
+		mips->printBlockCacheStats();
+	}
+	else if (mode == "--fusion-report")
+	{
+		// time an unfused run on a second instance, with its final registers suppressed
+		MIPS_Architecture *unfused = new MIPS_Architecture(argv[1]);
+		unfused->fuse = false;
+		unfused->trace.reset(new NoTraceSink(std::cout));
+		std::streambuf *out = std::cout.rdbuf(nullptr);
+		double before = timeFastRun(unfused);
+		std::cout.rdbuf(out);
+		std::cout.clear();
+		double after = timeFastRun(mips);
+		mips->printFusionReport();
+		std::cerr << "Unfused: " << before << "s, fused: " << after << "s, speedup: " << (after > 0 ? before / after : 0) << "x\n";
+	}
+	else
+		mips->executeCommandsUnpipelined();
+	mips->trace.reset();
+
+	if (profileTop == 0 && profileFile.empty())
+		return 0;
+	PcProfile profile;
+	profile.fromExecutions(*mips);
+	if (profileTop > 0)
+		profile.print(*mips, profileTop);
+	if (!profileFile.empty())
+	{
+		std::ofstream csv(profileFile);
+		if (csv.is_open())
+			profile.writeCsv(csv, *mips);
+		else
+			std::cerr << "Profile file could not be opened\n";
+	}
 	return 0;
 }
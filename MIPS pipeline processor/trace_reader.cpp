@@ -0,0 +1,44 @@
+#include "MIPS_Trace.hpp"
+#include <iostream>
+
+// reads a delta trace (--trace=delta) back: converts it to the text format or prints the state at one cycle
+int main(int argc, char *argv[])
+{
+	std::string mode = argc >= 3 ? argv[2] : "";
+	if (!((argc == 3 && mode == "--text") || (argc == 4 && mode == "--cycle")))
+	{
+		std::cerr << "Required arguments: trace_file and mode\n./trace_reader <trace file> --text\n./trace_reader <trace file> --cycle <cycle number>\n";
+		return 0;
+	}
+	DeltaTraceReader reader;
+	if (!reader.open(argv[1]))
+	{
+		std::cerr << "File could not be opened as a delta trace. Terminating...\n";
+		return 0;
+	}
+
+	if (mode == "--text")
+	{
+		TextTraceSink text(std::cout);
+		while (reader.next())
+			text.cycle(reader.cycle, reader.registers, reader.data);
+		text.finish(reader.cycle, reader.registers, reader.data);
+		return 0;
+	}
+
+	// records are consecutive cycles, so the first one gives the cycle numbering
+	long long wanted = atoll(argv[3]);
+	if (!reader.seek(0) || wanted < reader.cycle || !reader.seek(wanted - reader.cycle))
+	{
+		std::cerr << "Cycle " << wanted << " is not in the trace\n";
+		return 0;
+	}
+	std::cout << "Cycle number: " << reader.cycle << '\n';
+	for (int i = 0; i < 32; ++i)
+		std::cout << reader.registers[i] << ' ';
+	std::cout << "\n\nFollowing are the non-zero data values:\n";
+	reader.data.forEachNonZero([](uint32_t i, int value)
+							   { std::cout << 4 * i << '-' << 4 * i + 3 << std::hex << ": " << value << '\n'
+										   << std::dec; });
+	return 0;
+}